@@ -0,0 +1,152 @@
+/*
+ * File:   async_report_sink.cpp
+ * Author: massimo
+ *
+ * Created on October 16, 2026, 2:05 PM
+ */
+#include "async_report_sink.h"
+#include "time_support.h"
+#include <sstream>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+namespace
+{
+std::size_t
+roundUpToPowerOf2(const std::size_t n) noexcept
+{
+  std::size_t&& p {1};
+
+  while ( p < n )
+  {
+    p <<= 1;
+  }
+  return p;
+}
+}  // namespace
+
+asyncReportSink::ring::ring(const std::size_t capacity)
+:
+m_records(roundUpToPowerOf2(capacity)),
+m_mask{m_records.size() - 1}
+{}
+
+asyncReportSink::asyncReportSink(std::ostream& log,
+                                 const std::size_t ringCapacity,
+                                 const std::chrono::milliseconds& drainPeriod)
+:
+m_log(log),
+m_drainPeriod{drainPeriod},
+m_rings{[ringCapacity] () { return std::make_unique<ring>(ringCapacity); }}
+{
+  m_drainer = std::thread(&asyncReportSink::drainerLoop, this);
+}
+
+asyncReportSink::~asyncReportSink() noexcept
+{
+  {
+    std::lock_guard<std::mutex> lock {m_mutex};
+
+    m_stopRequested = true;
+  }
+  m_wakeUp.notify_one();
+  if ( m_drainer.joinable() )
+  {
+    m_drainer.join();
+  }
+}
+
+void
+asyncReportSink::flush()
+{
+  std::unique_lock<std::mutex> lock {m_mutex};
+  const uint_fast64_t target {++m_flushRequested};
+
+  m_wakeUp.notify_one();
+  m_flushed.wait(lock, [this, target] () { return m_flushCompleted >= target; });
+}
+
+uint_fast64_t
+asyncReportSink::getDroppedRecords() const noexcept
+{
+  uint_fast64_t dropped {0};
+
+  m_rings.forEach([&dropped] (const ring& r) { dropped += r.getDropped(); });
+
+  return dropped;
+}
+
+void
+asyncReportSink::drainerLoop()
+{
+  std::unique_lock<std::mutex> lock {m_mutex};
+
+  for (;;)
+  {
+    m_wakeUp.wait_for(lock, m_drainPeriod, [this] ()
+    {
+      return m_stopRequested || (m_flushRequested != m_flushCompleted);
+    });
+
+    const uint_fast64_t flushTarget {m_flushRequested};
+    const bool stopping {m_stopRequested};
+
+    // format and write without holding the lock, so flush() callers and the
+    // dtor are never blocked behind the stream
+    lock.unlock();
+    drainAll();
+    lock.lock();
+
+    m_flushCompleted = flushTarget;
+    m_flushed.notify_all();
+    if ( stopping )
+    {
+      return;
+    }
+  }
+}
+
+std::size_t
+asyncReportSink::drainAll()
+{
+  std::ostringstream batch {};
+  std::size_t drained {0};
+  uint_fast64_t dropped {0};
+
+  m_rings.forEach([&batch, &drained, &dropped] (ring& r)
+  {
+    drained += r.drain([&batch] (const reportRecord& rec)
+    {
+      rdtscTimer::writeReport(batch,
+                              labelName(rec.timerId),
+                              labelName(rec.startLabel),
+                              labelName(rec.stopLabel),
+                              rec.start,
+                              rec.stop,
+                              rec.overhead,
+                              rec.startCpu,
+                              rec.stopCpu,
+                              rec.counters);
+    });
+    dropped += r.getDropped();
+  });
+
+  if ( dropped > m_droppedReported )
+  {
+    batch << "asyncReportSink: "
+          << dropped - m_droppedReported
+          << " records dropped: ring full"
+          << '\n';
+    m_droppedReported = dropped;
+  }
+
+  if ( 0 != batch.tellp() )
+  {
+    m_log << batch.str();
+    m_log.flush();
+  }
+  m_written.store(m_written.load(std::memory_order_relaxed) + drained, std::memory_order_relaxed);
+
+  return drained;
+}
+}  // namespace timeSupport
@@ -0,0 +1,155 @@
+/*
+ * File:   async_report_sink.h
+ * Author: massimo
+ *
+ * Created on October 16, 2026, 2:05 PM
+ */
+#pragma once
+
+#include "labels.h"
+#include "perf_counters.h"
+#include "tsc_clock.h"
+#include "thread_shards.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+// the raw data of a report line: formatted later by the drainer thread
+struct reportRecord
+{
+  labelId timerId {};
+  labelId startLabel {};
+  labelId stopLabel {};
+  uint_fast64_t start {};
+  uint_fast64_t stop {};
+  // measurement overhead of the reporting thread
+  uint_fast64_t overhead {};
+  uint32_t startCpu {unknownCpu};
+  uint32_t stopCpu {unknownCpu};
+  perfCounterValues counters {};
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// asynchronous sink for timer reports
+// hot threads push raw records into their own single-producer/single-consumer
+// lock-free ring; a background thread drains the rings, formats the records
+// and writes them to the stream in batches, so the timed threads never block
+// on the stream; when a ring is full the record is dropped and counted
+// the sink must outlive the timers reporting to it
+class asyncReportSink final
+{
+ public:
+  explicit asyncReportSink(std::ostream& log = std::cout,
+                           const std::size_t ringCapacity = 4096,
+                           const std::chrono::milliseconds& drainPeriod = std::chrono::milliseconds(1));
+
+  // drain what is left and stop the drainer thread
+  ~asyncReportSink() noexcept;
+
+  asyncReportSink(const asyncReportSink&) = delete;
+  asyncReportSink& operator=(const asyncReportSink&) = delete;
+
+  // false when the calling thread's ring is full and the record is dropped
+  bool
+  push(const reportRecord& r) noexcept
+  {
+    return m_rings.local().push(r);
+  }
+
+  // block until all the records pushed before the call are written
+  void flush();
+
+  uint_fast64_t getDroppedRecords() const noexcept;
+
+  uint_fast64_t
+  getWrittenRecords() const noexcept
+  {
+    return m_written.load(std::memory_order_relaxed);
+  }
+
+ private:
+  class ring final
+  {
+   public:
+    explicit ring(const std::size_t capacity);
+
+    // producer side: the owning thread only
+    bool
+    push(const reportRecord& r) noexcept
+    {
+      const uint_fast64_t h {m_head.load(std::memory_order_relaxed)};
+
+      if ( (h - m_cachedTail) > m_mask )
+      {
+        m_cachedTail = m_tail.load(std::memory_order_acquire);
+        if ( (h - m_cachedTail) > m_mask )
+        {
+          m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+          return false;
+        }
+      }
+      m_records[h & m_mask] = r;
+      m_head.store(h + 1, std::memory_order_release);
+
+      return true;
+    }
+
+    // consumer side: the drainer thread only
+    template <typename F>
+    std::size_t
+    drain(F&& f)
+    {
+      uint_fast64_t t {m_tail.load(std::memory_order_relaxed)};
+      const uint_fast64_t h {m_head.load(std::memory_order_acquire)};
+      const std::size_t n {static_cast<std::size_t>(h - t)};
+
+      for (; t != h; ++t)
+      {
+        f(m_records[t & m_mask]);
+      }
+      m_tail.store(t, std::memory_order_release);
+
+      return n;
+    }
+
+    uint_fast64_t
+    getDropped() const noexcept
+    {
+      return m_dropped.load(std::memory_order_relaxed);
+    }
+
+   private:
+    std::vector<reportRecord> m_records;
+    const uint_fast64_t m_mask;
+    alignas(64) std::atomic<uint_fast64_t> m_head {0};
+    uint_fast64_t m_cachedTail {0};
+    std::atomic<uint_fast64_t> m_dropped {0};
+    alignas(64) std::atomic<uint_fast64_t> m_tail {0};
+  };  // class ring
+
+  std::ostream& m_log;
+  const std::chrono::milliseconds m_drainPeriod;
+  threadShards<ring> m_rings;
+  std::atomic<uint_fast64_t> m_written {0};
+  uint_fast64_t m_droppedReported {0};
+  std::mutex m_mutex {};
+  std::condition_variable m_wakeUp {};
+  std::condition_variable m_flushed {};
+  uint_fast64_t m_flushRequested {0};
+  uint_fast64_t m_flushCompleted {0};
+  bool m_stopRequested {false};
+  std::thread m_drainer {};
+
+  void drainerLoop();
+
+  std::size_t drainAll();
+};  // class asyncReportSink
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
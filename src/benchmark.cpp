@@ -0,0 +1,157 @@
+/*
+ * File:   benchmark.cpp
+ * Author: massimo
+ *
+ * Created on October 18, 2026, 3:40 PM
+ */
+#include "benchmark.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+namespace
+{
+// the value at quantile q of sorted values, linearly interpolated
+double
+quantile(const std::vector<double>& sorted, const double q) noexcept
+{
+  if ( sorted.empty() )
+  {
+    return 0.0;
+  }
+
+  const double position {q * static_cast<double>(sorted.size() - 1)};
+  const std::size_t below {static_cast<std::size_t>(position)};
+  const std::size_t above {std::min(below + 1, sorted.size() - 1)};
+  const double fraction {position - static_cast<double>(below)};
+
+  return sorted[below] + ((sorted[above] - sorted[below]) * fraction);
+}
+
+// two-sided normal critical value of the confidence level
+double
+criticalValue(const double confidence) noexcept
+{
+  if ( confidence >= 0.99 )
+  {
+    return 2.576;
+  }
+  if ( confidence >= 0.95 )
+  {
+    return 1.960;
+  }
+  return 1.645;
+}
+
+double
+toNanoseconds(const double ticks) noexcept
+{
+  return (ticks * 1e9) / static_cast<double>(tsc_clock::calibration().tscHz);
+}
+}  // namespace
+
+benchmarkResult
+summarizeBenchmark(const std::string& name,
+                   std::vector<double>& samples,
+                   const uint_fast64_t iterationsPerSample,
+                   const benchmarkOptions& options)
+{
+  benchmarkResult&& r {};
+
+  r.name = name;
+  r.iterationsPerSample = iterationsPerSample;
+  if ( samples.empty() )
+  {
+    return r;
+  }
+
+  std::sort(samples.begin(), samples.end());
+
+  const double median {quantile(samples, 0.5)};
+  std::vector<double> deviations {};
+
+  deviations.reserve(samples.size());
+  for (auto&& s : samples)
+  {
+    deviations.push_back(std::fabs(s - median));
+  }
+  std::sort(deviations.begin(), deviations.end());
+  r.mad = quantile(deviations, 0.5);
+
+  // with MAD == 0 more than half of the samples are equal: keep all
+  if ( r.mad > 0.0 )
+  {
+    const double limit {options.madThreshold * 1.4826 * r.mad};
+
+    samples.erase(std::remove_if(samples.begin(), samples.end(), [median, limit] (const double s)
+    {
+      return std::fabs(s - median) > limit;
+    }), samples.end());
+    r.rejected = deviations.size() - samples.size();
+  }
+
+  // still sorted
+  const double n {static_cast<double>(samples.size())};
+  double sum {0.0};
+
+  for (auto&& s : samples)
+  {
+    sum += s;
+  }
+  r.samples = samples.size();
+  r.min = samples.front();
+  r.median = quantile(samples, 0.5);
+  r.mean = sum / n;
+  r.p99 = quantile(samples, 0.99);
+
+  double squares {0.0};
+
+  for (auto&& s : samples)
+  {
+    squares += (s - r.mean) * (s - r.mean);
+  }
+
+  const double stddev {(samples.size() > 1) ? std::sqrt(squares / (n - 1.0)) : 0.0};
+  const double halfWidth {criticalValue(options.confidence) * stddev / std::sqrt(n)};
+
+  r.ciLow = r.mean - halfWidth;
+  r.ciHigh = r.mean + halfWidth;
+
+  return r;
+}
+
+std::ostream& operator<<(std::ostream& os, const benchmarkResult& obj)
+{
+  const std::vector<std::pair<const char*, double>> values {
+    {"min",    obj.min},
+    {"median", obj.median},
+    {"mean",   obj.mean},
+    {"MAD",    obj.mad},
+    {"p99",    obj.p99}
+  };
+  const auto flags {os.flags()};
+  const auto precision {os.precision()};
+
+  os << obj.name << ": "
+     << obj.samples << " samples of "
+     << obj.iterationsPerSample << " iterations ("
+     << obj.rejected << " outliers rejected):"
+     << std::fixed << std::setprecision(2);
+  for (auto&& v : values)
+  {
+    os << ' ' << v.first << ' ' << v.second;
+  }
+  os << " CI [" << obj.ciLow << ", " << obj.ciHigh << "] ticks [";
+  for (auto&& v : values)
+  {
+    os << ' ' << v.first << ' ' << toNanoseconds(v.second);
+  }
+  os << " CI [" << toNanoseconds(obj.ciLow) << ", " << toNanoseconds(obj.ciHigh) << "] nsec ]";
+  os.flags(flags);
+  os.precision(precision);
+
+  return os;
+}
+}  // namespace timeSupport
@@ -0,0 +1,189 @@
+/*
+ * File:   benchmark.h
+ * Author: massimo
+ *
+ * Created on October 18, 2026, 3:40 PM
+ */
+#pragma once
+
+#include "time_support.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+// make the compiler believe value is read (and, when not const, written), so
+// the work producing it is not optimized away
+template <typename T>
+inline
+void
+doNotOptimize(const T& value) noexcept
+{
+  __asm__ __volatile__("" : : "r,m"(value) : "memory");
+}
+
+template <typename T>
+inline
+void
+doNotOptimize(T& value) noexcept
+{
+  __asm__ __volatile__("" : "+r,m"(value) : : "memory");
+}
+
+// make the compiler believe all the memory is read and written, so pending
+// stores are done inside the measured region
+inline
+void
+clobberMemory() noexcept
+{
+  __asm__ __volatile__("" : : : "memory");
+}
+
+struct benchmarkOptions
+{
+  // the callable runs unmeasured for this long first
+  std::chrono::nanoseconds warmupTime {std::chrono::milliseconds(50)};
+  // the measure lasts at least this long, unless maxSamples are taken
+  std::chrono::nanoseconds minTime {std::chrono::milliseconds(200)};
+  uint_fast64_t minSamples {100};
+  uint_fast64_t maxSamples {100'000};
+  // a sample is timed over enough iterations to make the measurement
+  // overhead this many times smaller than the sample
+  uint_fast64_t overheadRatio {100};
+  // samples farther than madThreshold * 1.4826 * MAD from the median are
+  // rejected as outliers (1.4826 * MAD estimates the standard deviation)
+  double madThreshold {3.5};
+  // two-sided confidence level of the mean's interval: 0.90, 0.95 or 0.99
+  double confidence {0.95};
+};
+
+// the per-iteration statistics of a benchmark, in ticks, overhead corrected;
+// min, median, mean, p99 and the confidence interval are taken over the
+// samples kept, MAD over all the samples
+struct benchmarkResult
+{
+  std::string name {};
+  uint_fast64_t iterationsPerSample {};
+  uint_fast64_t samples {};
+  uint_fast64_t rejected {};
+  double min {};
+  double median {};
+  double mean {};
+  double mad {};
+  double p99 {};
+  double ciLow {};
+  double ciHigh {};
+
+  // writes the statistics in ticks and nsec per iteration
+  friend std::ostream& operator<<(std::ostream& os, const benchmarkResult& obj);
+};
+
+// reject the outliers and compute the statistics of the ticks per iteration
+// samples; samples is reordered
+benchmarkResult summarizeBenchmark(const std::string& name,
+                                   std::vector<double>& samples,
+                                   const uint_fast64_t iterationsPerSample,
+                                   const benchmarkOptions& options);
+
+////////////////////////////////////////////////////////////////////////////////
+// statistical micro-benchmark of func(params...), invoked as profileFunction
+// invokes it: warm up, grow the iterations per sample until the measurement
+// overhead is negligible, take samples for minTime and summarize them
+// the result of func is passed to doNotOptimize(); func and params are not
+// forwarded since they are used again by every iteration
+template <typename F, typename... Args>
+benchmarkResult
+runBenchmark(const benchmarkOptions& options,
+             const std::string& name,
+             F&& func, Args&&... params)
+{
+  auto&& once = [&func, &params...] ()
+  {
+#ifdef CALL_STD_FORWARD // define this macro in this case (used in the unit tests)
+    if constexpr ( std::is_void_v<decltype(func(params...))> )
+    {
+      func(params...);
+    }
+    else
+    {
+      doNotOptimize(func(params...));
+    }
+#else
+    if constexpr ( std::is_void_v<std::invoke_result_t<F&, Args&...>> )
+    {
+      std::invoke(func, params...);
+    }
+    else
+    {
+      doNotOptimize(std::invoke(func, params...));
+    }
+#endif
+  };
+  auto&& timed = [&once] (const uint_fast64_t iterations)
+  {
+    const uint_fast64_t start {startTSC()};
+
+    for (uint_fast64_t&& i {0}; i < iterations; ++i)
+    {
+      once();
+    }
+    clobberMemory();
+
+    return stopTSC() - start;
+  };
+  auto&& toTicks = [] (const std::chrono::nanoseconds& t)
+  {
+    return static_cast<uint_fast64_t>((static_cast<double>(t.count()) * static_cast<double>(tsc_clock::calibration().tscHz)) / 1e9);
+  };
+
+  const uint_fast64_t overhead {rdtscTimer::getMeasurementOverhead()};
+
+  // warm up
+  const uint_fast64_t warmupTicks {toTicks(options.warmupTime)};
+  const uint_fast64_t warmupStart {stopTSC()};
+
+  while ( (stopTSC() - warmupStart) < warmupTicks )
+  {
+    once();
+  }
+
+  // iterations per sample
+  uint_fast64_t iterations {1};
+
+  while ( (timed(iterations) < (options.overheadRatio * overhead)) &&
+          (iterations < (uint_fast64_t{1} << 40)) )
+  {
+    iterations *= 2;
+  }
+
+  // samples
+  const uint_fast64_t minTicks {toTicks(options.minTime)};
+  const uint_fast64_t measureStart {stopTSC()};
+  std::vector<double> samples {};
+
+  samples.reserve(options.minSamples);
+  while ( (samples.size() < options.maxSamples) &&
+          ((samples.size() < options.minSamples) || ((stopTSC() - measureStart) < minTicks)) )
+  {
+    const uint_fast64_t ticks {timed(iterations)};
+    const uint_fast64_t corrected {(ticks > overhead) ? (ticks - overhead) : 0};
+
+    samples.push_back(static_cast<double>(corrected) / static_cast<double>(iterations));
+  }
+
+  return summarizeBenchmark(name, samples, iterations, options);
+}
+
+template <typename F, typename... Args>
+benchmarkResult
+runBenchmark(const std::string& name, F&& func, Args&&... params)
+{
+  return runBenchmark(benchmarkOptions{}, name, std::forward<F>(func), std::forward<Args>(params)...);
+}
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
@@ -0,0 +1,301 @@
+//
+//  timerOverhead.cpp
+//
+//  the cost of the timer's own operations, with the TSC and the null
+//  backends, several label lengths and report streams, written as JSON or CSV
+//  so that a regression of the library shows up in a diff of two runs
+//
+//  every case returns the ticks of its timer, which runBenchmark() passes to
+//  doNotOptimize(): the loops of a nullTimer, whose members compile to
+//  nothing, are measured as the empty loops they are, not optimized away
+//
+#include "../benchmark.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+enum class outputFormat { JSON, CSV };
+
+struct caseResult
+{
+  std::string operation {};
+  std::string backend {};
+  // 0: labels interned once, outside the measure
+  std::size_t labelLength {};
+  std::string sink {};
+  timeSupport::benchmarkResult result {};
+};
+
+static
+void
+usage(const char* program) noexcept
+{
+  std::cerr << "usage: "
+            << program
+            << " [--json | --csv] [--min-time <msec>]"
+            << '\n'
+            << "  --json             one JSON document (default)"
+            << '\n'
+            << "  --csv              one CSV line per operation"
+            << '\n'
+            << "  --min-time <msec>  measure each operation for at least this long (default 100)"
+            << '\n';
+}
+
+static
+double
+toNanoseconds(const double ticks) noexcept
+{
+  return (ticks * 1e9) / static_cast<double>(timeSupport::tsc_clock::calibration().tscHz);
+}
+
+// the stringstream is emptied every 4096 reports, so it does not grow for
+// the whole measure
+template <typename timerType>
+static
+void
+reportCases(const char* backendName,
+            const timeSupport::benchmarkOptions& options,
+            const std::size_t labelLength,
+            std::vector<caseResult>& results)
+{
+  std::stringstream ss {};
+  std::ofstream devNull {"/dev/null"};
+  const timeSupport::timeLabel startLabel {std::string(labelLength, 's')};
+  const timeSupport::timeLabel stopLabel {std::string(labelLength, 'S')};
+
+  {
+    timerType t {"overhead", ss};
+    uint_fast64_t reports {0};
+
+    results.push_back({"start_stop_report", backendName, labelLength, "stringstream",
+                       timeSupport::runBenchmark(options, "start_stop_report", [&t, &ss, &reports, &startLabel, &stopLabel] ()
+    {
+      t.start(startLabel);
+      t.stop(stopLabel).report();
+      if ( 0 == (++reports & 4095) )
+      {
+        ss.str("");
+      }
+      return t.getStopLapsedTSC();
+    })});
+  }
+  {
+    timerType t {"overhead", devNull};
+
+    results.push_back({"start_stop_report", backendName, labelLength, "devnull",
+                       timeSupport::runBenchmark(options, "start_stop_report", [&t, &startLabel, &stopLabel] ()
+    {
+      t.start(startLabel);
+      t.stop(stopLabel).report();
+      return t.getStopLapsedTSC();
+    })});
+  }
+}
+
+template <typename backend>
+static
+void
+runCases(const char* backendName,
+         const timeSupport::benchmarkOptions& options,
+         std::vector<caseResult>& results)
+{
+  using timerType = timeSupport::timer<backend>;
+
+  std::stringstream ss {};
+  std::ofstream devNull {"/dev/null"};
+  const timeSupport::timeLabel startLabel {"START"};
+  const timeSupport::timeLabel stopLabel {"STOP"};
+  const std::vector<std::size_t> labelLengths {8, 64, 256};
+
+  {
+    timerType t {"overhead", devNull};
+
+    results.push_back({"start_stop", backendName, 0, "none",
+                       timeSupport::runBenchmark(options, "start_stop", [&t, &startLabel, &stopLabel] ()
+    {
+      t.start(startLabel);
+      return t.stop(stopLabel).getStopLapsedTSC();
+    })});
+  }
+
+  // one run in 16 timed: the others read no clock
+  {
+    timerType t {"overhead", devNull};
+
+    t.sampleEvery(16);
+    results.push_back({"start_stop_sampled_16", backendName, 0, "none",
+                       timeSupport::runBenchmark(options, "start_stop_sampled_16", [&t, &startLabel, &stopLabel] ()
+    {
+      t.start(startLabel);
+      return t.stop(stopLabel).getStopLapsedTSC();
+    })});
+  }
+
+  // labels passed as text are interned at every call
+  for (auto&& length : labelLengths)
+  {
+    timerType t {"overhead", devNull};
+    const std::string startText(length, 's');
+    const std::string stopText(length, 'S');
+
+    results.push_back({"start_stop_text_labels", backendName, length, "none",
+                       timeSupport::runBenchmark(options, "start_stop_text_labels", [&t, &startText, &stopText] ()
+    {
+      t.start(startText.c_str());
+      return t.stop(stopText.c_str()).getStopLapsedTSC();
+    })});
+  }
+
+  for (auto&& length : labelLengths)
+  {
+    reportCases<timerType>(backendName, options, length, results);
+  }
+
+  {
+    timerType t {"overhead", devNull};
+
+    t.start(startLabel);
+    t.stop(stopLabel);
+    results.push_back({"get_stop_lapsed_nsec", backendName, 0, "none",
+                       timeSupport::runBenchmark(options, "get_stop_lapsed_nsec", [&t] ()
+    {
+      return t.getStopLapsed_nsec();
+    })});
+  }
+
+  // the dtor stops the timer and reports
+  {
+    uint_fast64_t reports {0};
+
+    results.push_back({"ctor_start_dtor", backendName, 0, "stringstream",
+                       timeSupport::runBenchmark(options, "ctor_start_dtor", [&ss, &reports, &startLabel] ()
+    {
+      uint_fast64_t start {0};
+
+      {
+        timerType t {"overhead", ss};
+
+        start = t.start(startLabel).getStartTSC();
+      }
+      if ( 0 == (++reports & 4095) )
+      {
+        ss.str("");
+      }
+      return start;
+    })});
+  }
+  results.push_back({"ctor_start_dtor", backendName, 0, "devnull",
+                     timeSupport::runBenchmark(options, "ctor_start_dtor", [&devNull, &startLabel] ()
+  {
+    timerType t {"overhead", devNull};
+
+    return t.start(startLabel).getStartTSC();
+  })});
+}
+
+static
+void
+writeCSV(const std::vector<caseResult>& results, std::ostream& os)
+{
+  os << "operation,backend,label_length,sink,samples,iterations_per_sample,"
+     << "min_ticks,median_ticks,mean_ticks,mad_ticks,p99_ticks,median_nsec"
+     << '\n';
+  for (auto&& c : results)
+  {
+    os << c.operation << ','
+       << c.backend << ','
+       << c.labelLength << ','
+       << c.sink << ','
+       << c.result.samples << ','
+       << c.result.iterationsPerSample << ','
+       << c.result.min << ','
+       << c.result.median << ','
+       << c.result.mean << ','
+       << c.result.mad << ','
+       << c.result.p99 << ','
+       << toNanoseconds(c.result.median)
+       << '\n';
+  }
+}
+
+static
+void
+writeJSON(const std::vector<caseResult>& results, std::ostream& os)
+{
+  os << "{\"tsc_hz\":" << timeSupport::tsc_clock::calibration().tscHz
+     << ",\"clock_backend\":\"" << timeSupport::clockBackendName(timeSupport::activeClockBackend()) << "\""
+     << ",\"measurement_overhead_ticks\":" << timeSupport::rdtscTimer::getMeasurementOverhead()
+     << ",\"results\":[";
+  for (std::size_t&& i {0}; i < results.size(); ++i)
+  {
+    const caseResult& c = results[i];
+
+    os << ((0 == i) ? "\n" : ",\n")
+       << "{\"operation\":\"" << c.operation << "\""
+       << ",\"backend\":\"" << c.backend << "\""
+       << ",\"label_length\":" << c.labelLength
+       << ",\"sink\":\"" << c.sink << "\""
+       << ",\"samples\":" << c.result.samples
+       << ",\"iterations_per_sample\":" << c.result.iterationsPerSample
+       << ",\"min_ticks\":" << c.result.min
+       << ",\"median_ticks\":" << c.result.median
+       << ",\"mean_ticks\":" << c.result.mean
+       << ",\"mad_ticks\":" << c.result.mad
+       << ",\"p99_ticks\":" << c.result.p99
+       << ",\"median_nsec\":" << toNanoseconds(c.result.median)
+       << "}";
+  }
+  os << "\n]}\n";
+}
+
+int
+main(int argc, char* argv[])
+{
+  outputFormat format {outputFormat::JSON};
+  timeSupport::benchmarkOptions options {};
+
+  options.minTime = std::chrono::milliseconds(100);
+  for (int&& i {1}; i < argc; ++i)
+  {
+    if ( 0 == std::strcmp(argv[i], "--json") )
+    {
+      format = outputFormat::JSON;
+    }
+    else if ( 0 == std::strcmp(argv[i], "--csv") )
+    {
+      format = outputFormat::CSV;
+    }
+    else if ( (0 == std::strcmp(argv[i], "--min-time")) && ((i + 1) < argc) )
+    {
+      options.minTime = std::chrono::milliseconds(std::strtoul(argv[++i], nullptr, 10));
+    }
+    else
+    {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  std::vector<caseResult> results {};
+
+  runCases<timeSupport::tscBackend>("rdtscTimer", options, results);
+  runCases<timeSupport::nullBackend>("nullTimer", options, results);
+
+  switch ( format )
+  {
+    case outputFormat::JSON:
+      writeJSON(results, std::cout);
+      break;
+    case outputFormat::CSV:
+      writeCSV(results, std::cout);
+      break;
+  }
+
+  return 0;
+}
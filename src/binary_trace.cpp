@@ -0,0 +1,540 @@
+/*
+ * File:   binary_trace.cpp
+ * Author: massimo
+ *
+ * Created on October 17, 2026, 9:30 AM
+ */
+#include "binary_trace.h"
+#include "latency_histogram.h"
+#include "time_support.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <tuple>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+namespace
+{
+constexpr uint_fast32_t minChunkShift {9};
+
+// mmap() offsets must be page aligned
+static_assert((((std::size_t{1} << minChunkShift) * sizeof(traceRecord)) % 4096) == 0);
+
+bool
+writeAll(const int fd, const void* data, const std::size_t size, const off_t offset) noexcept
+{
+  const char* p {static_cast<const char*>(data)};
+  std::size_t written {0};
+
+  while ( written < size )
+  {
+    const ssize_t n {pwrite(fd, p + written, size - written, offset + static_cast<off_t>(written))};
+
+    if ( n < 0 )
+    {
+      if ( EINTR == errno )
+      {
+        continue;
+      }
+      return false;
+    }
+    written += static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+traceFileHeader
+makeHeader() noexcept
+{
+  const tscCalibration& c = tsc_clock::calibration();
+  traceFileHeader&& h {};
+
+  h.magic = traceMagic;
+  h.version = traceVersion;
+  h.recordSize = sizeof(traceRecord);
+  h.tscHz = c.tscHz;
+  h.tscMult = c.mult;
+  h.tscShift = static_cast<uint32_t>(c.shift);
+  h.overheadTicks = static_cast<uint32_t>(rdtscTimer::getMeasurementOverhead());
+  h.processId = static_cast<uint32_t>(getpid());
+
+  return h;
+}
+}  // namespace
+
+uint32_t
+traceThreadId() noexcept
+{
+  static thread_local const uint32_t tid {static_cast<uint32_t>(syscall(SYS_gettid))};
+
+  return tid;
+}
+
+traceWriter::traceWriter(const std::string& fileName,
+                         const std::size_t chunkRecords)
+:
+m_fileName{fileName}
+{
+  m_chunkShift = minChunkShift;
+  while ( (std::size_t{1} << m_chunkShift) < chunkRecords )
+  {
+    ++m_chunkShift;
+  }
+  m_chunkMask = (uint64_t{1} << m_chunkShift) - 1;
+  m_chunkBytes = (std::size_t{1} << m_chunkShift) * sizeof(traceRecord);
+
+  m_fd = ::open(m_fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if ( m_fd < 0 )
+  {
+    return;
+  }
+
+  // the calibration goes in the header at once: a trace that is never
+  // closed can still be decoded
+  const traceFileHeader&& h = makeHeader();
+
+  if ( (0 != ftruncate(m_fd, static_cast<off_t>(traceDataOffset))) ||
+       (!writeAll(m_fd, &h, sizeof(h), 0)) )
+  {
+    ::close(m_fd);
+    m_fd = -1;
+    return;
+  }
+
+  // map the first chunk now, not in the first timed region
+  mapChunk(0);
+}
+
+traceWriter::~traceWriter() noexcept
+{
+  close();
+}
+
+traceRecord*
+traceWriter::mapChunk(const uint64_t chunk) noexcept
+{
+  std::lock_guard<std::mutex> lock {m_mutex};
+  traceRecord* base {m_chunks[chunk].load(std::memory_order_relaxed)};
+
+  if ( (nullptr != base) || (m_fd < 0) )
+  {
+    return base;
+  }
+
+  const off_t offset {static_cast<off_t>(traceDataOffset + (chunk * m_chunkBytes))};
+  const off_t end {offset + static_cast<off_t>(m_chunkBytes)};
+  struct stat st {};
+  void* p {MAP_FAILED};
+
+  if ( (0 == fstat(m_fd, &st)) &&
+       ((st.st_size >= end) || (0 == ftruncate(m_fd, end))) )
+  {
+    p = mmap(nullptr, m_chunkBytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, offset);
+  }
+  if ( MAP_FAILED == p )
+  {
+    const uint64_t limit {chunk << m_chunkShift};
+
+    if ( limit < m_mappedLimit.load(std::memory_order_relaxed) )
+    {
+      m_mappedLimit.store(limit, std::memory_order_relaxed);
+    }
+    return nullptr;
+  }
+
+  base = static_cast<traceRecord*>(p);
+  m_chunks[chunk].store(base, std::memory_order_release);
+
+  return base;
+}
+
+uint_fast64_t
+traceWriter::getRecordsCount() const noexcept
+{
+  const uint64_t capacity {static_cast<uint64_t>(maxChunks) << m_chunkShift};
+
+  return std::min({m_next.load(std::memory_order_relaxed),
+                   m_mappedLimit.load(std::memory_order_relaxed),
+                   capacity});
+}
+
+void
+traceWriter::close() noexcept
+{
+  std::lock_guard<std::mutex> lock {m_mutex};
+
+  if ( m_fd < 0 )
+  {
+    return;
+  }
+
+  const uint64_t recordsCount {getRecordsCount()};
+
+  for (auto&& c : m_chunks)
+  {
+    traceRecord* p {c.exchange(nullptr)};
+
+    if ( nullptr != p )
+    {
+      munmap(p, m_chunkBytes);
+    }
+  }
+
+  // the label table: all the labels interned so far, by id
+  std::string table {};
+  const std::size_t labelsCount {internedLabelsCount()};
+
+  for (labelId&& id {0}; id < labelsCount; ++id)
+  {
+    const std::string& name = labelName(id);
+    const uint32_t size {static_cast<uint32_t>(name.size())};
+
+    table.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    table.append(name);
+  }
+
+  traceFileHeader&& h = makeHeader();
+
+  h.recordsCount = recordsCount;
+  h.labelsOffset = traceDataOffset + (recordsCount * sizeof(traceRecord));
+  h.labelsCount = labelsCount;
+
+  if ( (0 != ftruncate(m_fd, static_cast<off_t>(h.labelsOffset + table.size()))) ||
+       (!writeAll(m_fd, table.data(), table.size(), static_cast<off_t>(h.labelsOffset))) )
+  {
+    // keep the records: the reader counts them from the file size
+    h.labelsOffset = 0;
+    h.labelsCount = 0;
+  }
+  writeAll(m_fd, &h, sizeof(h), 0);
+
+  ::close(m_fd);
+  m_fd = -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+traceReader::traceReader(const std::string& fileName)
+{
+  const int fd {::open(fileName.c_str(), O_RDONLY | O_CLOEXEC)};
+
+  if ( fd < 0 )
+  {
+    m_error = fileName + ": " + std::strerror(errno);
+    return;
+  }
+
+  struct stat st {};
+
+  if ( 0 != fstat(fd, &st) )
+  {
+    m_error = fileName + ": " + std::strerror(errno);
+    ::close(fd);
+    return;
+  }
+  if ( static_cast<uint64_t>(st.st_size) < traceDataOffset )
+  {
+    m_error = fileName + ": not a trace file: too short";
+    ::close(fd);
+    return;
+  }
+
+  m_mapSize = static_cast<std::size_t>(st.st_size);
+  m_map = mmap(nullptr, m_mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if ( MAP_FAILED == m_map )
+  {
+    m_map = nullptr;
+    m_error = fileName + ": " + std::strerror(errno);
+    return;
+  }
+
+  std::memcpy(&m_header, m_map, sizeof(m_header));
+  if ( (traceMagic != m_header.magic) ||
+       (traceVersion != m_header.version) ||
+       (sizeof(traceRecord) != m_header.recordSize) )
+  {
+    m_error = fileName + ": not a trace file or unsupported trace version";
+    return;
+  }
+
+  const char* base {static_cast<const char*>(m_map)};
+
+  m_records = reinterpret_cast<const traceRecord*>(base + traceDataOffset);
+
+  if ( 0 == m_header.labelsOffset )
+  {
+    // not closed: count the records from the size, skipping the zero
+    // filled tail of the last chunk
+    m_recordsCount = (m_mapSize - traceDataOffset) / sizeof(traceRecord);
+    while ( (m_recordsCount > 0) &&
+            (0 == m_records[m_recordsCount - 1].start) &&
+            (0 == m_records[m_recordsCount - 1].stop) )
+    {
+      --m_recordsCount;
+    }
+    return;
+  }
+
+  m_recordsCount = std::min(m_header.recordsCount,
+                            static_cast<uint64_t>((m_mapSize - traceDataOffset) / sizeof(traceRecord)));
+
+  uint64_t offset {m_header.labelsOffset};
+
+  for (uint64_t&& i {0}; i < m_header.labelsCount; ++i)
+  {
+    uint32_t size {0};
+
+    if ( (offset + sizeof(size)) > m_mapSize )
+    {
+      break;
+    }
+    std::memcpy(&size, base + offset, sizeof(size));
+    offset += sizeof(size);
+    if ( (offset + size) > m_mapSize )
+    {
+      break;
+    }
+    m_labels.emplace_back(base + offset, size);
+    offset += size;
+  }
+}
+
+traceReader::~traceReader() noexcept
+{
+  if ( nullptr != m_map )
+  {
+    munmap(m_map, m_mapSize);
+  }
+}
+
+tscCalibration
+traceReader::getCalibration() const noexcept
+{
+  tscCalibration&& c {};
+
+  c.tscHz = m_header.tscHz;
+  c.mult = m_header.tscMult;
+  c.shift = m_header.tscShift;
+
+  return c;
+}
+
+std::string
+traceReader::getLabel(const labelId id) const
+{
+  if ( id < m_labels.size() )
+  {
+    return m_labels[id];
+  }
+  return "#" + std::to_string(id);
+}
+
+void
+writeTraceStatistics(const traceReader& trace,
+                     std::ostream& os,
+                     const bool keepCrossCore)
+{
+  using key = std::tuple<labelId, labelId, labelId>;
+
+  std::map<key, tickHistogram> statistics {};
+  uint64_t crossCore {0};
+
+  for (uint64_t&& i {0}; i < trace.getRecordsCount(); ++i)
+  {
+    const traceRecord& r = trace.getRecord(i);
+
+    if ( r.isCrossCore() )
+    {
+      ++crossCore;
+      if ( !keepCrossCore )
+      {
+        continue;
+      }
+    }
+    statistics[key{r.timerId, r.startLabel, r.stopLabel}].record(r.stop - r.start);
+  }
+
+  const tscCalibration&& c = trace.getCalibration();
+
+  os << trace.getRecordsCount()
+     << " records ("
+     << crossCore
+     << " cross-core, "
+     << (keepCrossCore ? "kept" : "dropped")
+     << "), TSC frequency "
+     << c.tscHz
+     << " Hz, measurement overhead "
+     << trace.getHeader().overheadTicks
+     << " ticks"
+     << '\n';
+
+  for (auto&& s : statistics)
+  {
+    const tickHistogram& h = s.second;
+    const std::vector<std::pair<const char*, uint_fast64_t>> values {
+      {"min",   h.getMin()},
+      {"mean",  static_cast<uint_fast64_t>(h.mean())},
+      {"p50",   h.percentile(0.50)},
+      {"p99",   h.percentile(0.99)},
+      {"p99.9", h.percentile(0.999)},
+      {"max",   h.getMax()}
+    };
+
+    os << trace.getLabel(std::get<0>(s.first)) << ": "
+       << trace.getLabel(std::get<1>(s.first)) << " -> "
+       << trace.getLabel(std::get<2>(s.first)) << ": "
+       << h.getCount() << " samples:";
+    for (auto&& v : values)
+    {
+      os << ' ' << v.first << ' ' << v.second;
+    }
+    os << " ticks [";
+    for (auto&& v : values)
+    {
+      os << ' ' << v.first << ' ' << ticksToNanoseconds(v.second, c);
+    }
+    os << " nsec ]" << '\n';
+  }
+}
+
+void
+writeTraceCSV(const traceReader& trace, std::ostream& os)
+{
+  // quote a label as a CSV field
+  auto&& field = [&trace] (const labelId id)
+  {
+    std::string&& f {"\""};
+
+    for (auto&& ch : trace.getLabel(id))
+    {
+      if ( '"' == ch )
+      {
+        f += '"';
+      }
+      f += ch;
+    }
+    return f + "\"";
+  };
+
+  const tscCalibration&& c = trace.getCalibration();
+
+  os << "timer,start_label,stop_label,thread,start_cpu,stop_cpu,start_tsc,stop_tsc,ticks,nsec" << '\n';
+  for (uint64_t&& i {0}; i < trace.getRecordsCount(); ++i)
+  {
+    const traceRecord& r = trace.getRecord(i);
+
+    os << field(r.timerId) << ','
+       << field(r.startLabel) << ','
+       << field(r.stopLabel) << ','
+       << r.threadId << ','
+       << r.startCpu << ','
+       << r.stopCpu << ','
+       << r.start << ','
+       << r.stop << ','
+       << r.stop - r.start << ','
+       << ticksToNanoseconds(r.stop - r.start, c)
+       << '\n';
+  }
+}
+
+namespace
+{
+// a JSON string literal
+std::string
+jsonString(const std::string& s)
+{
+  std::string&& j {"\""};
+
+  for (auto&& ch : s)
+  {
+    switch ( ch )
+    {
+      case '"':  j += "\\\""; break;
+      case '\\': j += "\\\\"; break;
+      case '\n': j += "\\n"; break;
+      case '\r': j += "\\r"; break;
+      case '\t': j += "\\t"; break;
+      default:
+        if ( static_cast<unsigned char>(ch) < 0x20 )
+        {
+          static const char hex[] {"0123456789abcdef"};
+
+          j += "\\u00";
+          j += hex[(ch >> 4) & 0xf];
+          j += hex[ch & 0xf];
+        }
+        else
+        {
+          j += ch;
+        }
+    }
+  }
+  return j + "\"";
+}
+
+// nanoseconds as microseconds with 3 decimals, as Chrome wants them
+void
+writeMicroseconds(std::ostream& os, const uint_fast64_t nsec)
+{
+  os << nsec / 1'000 << '.' << std::setw(3) << std::setfill('0') << nsec % 1'000 << std::setfill(' ');
+}
+}  // namespace
+
+void
+writeTraceChromeJSON(const traceReader& trace, std::ostream& os)
+{
+  const tscCalibration&& c = trace.getCalibration();
+  const uint64_t recordsCount {trace.getRecordsCount()};
+  uint64_t base {UINT64_MAX};
+
+  // records are stored roughly in stop order: find the earliest start first
+  for (uint64_t&& i {0}; i < recordsCount; ++i)
+  {
+    base = std::min(base, trace.getRecord(i).start);
+  }
+
+  // the label names are only built once each
+  std::vector<std::string> names {};
+
+  for (labelId&& id {0}; id < trace.getHeader().labelsCount; ++id)
+  {
+    names.push_back(jsonString(trace.getLabel(id)));
+  }
+  auto&& name = [&trace, &names] (const labelId id)
+  {
+    return (id < names.size()) ? names[id] : jsonString(trace.getLabel(id));
+  };
+
+  os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  for (uint64_t&& i {0}; i < recordsCount; ++i)
+  {
+    const traceRecord& r = trace.getRecord(i);
+    const uint64_t start {(r.start > base) ? (r.start - base) : 0};
+    const uint64_t lapsed {(r.stop > r.start) ? (r.stop - r.start) : 0};
+
+    os << ((0 == i) ? "\n" : ",\n")
+       << "{\"name\":" << name(r.timerId)
+       << ",\"cat\":\"timeSupport\",\"ph\":\"X\",\"pid\":" << trace.getHeader().processId
+       << ",\"tid\":" << r.threadId
+       << ",\"ts\":";
+    writeMicroseconds(os, ticksToNanoseconds(start, c));
+    os << ",\"dur\":";
+    writeMicroseconds(os, ticksToNanoseconds(lapsed, c));
+    os << ",\"args\":{\"start\":" << name(r.startLabel)
+       << ",\"stop\":" << name(r.stopLabel)
+       << ",\"ticks\":" << lapsed
+       << ",\"start_cpu\":" << r.startCpu
+       << ",\"stop_cpu\":" << r.stopCpu
+       << "}}";
+  }
+  os << "\n]}" << '\n';
+}
+}  // namespace timeSupport
@@ -0,0 +1,252 @@
+/*
+ * File:   binary_trace.h
+ * Author: massimo
+ *
+ * Created on October 17, 2026, 9:30 AM
+ */
+#pragma once
+
+#include "labels.h"
+#include "tsc_clock.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+// binary trace file layout:
+//   [0, traceDataOffset)            traceFileHeader, zero padded
+//   [traceDataOffset, labelsOffset) recordsCount traceRecord
+//   [labelsOffset, end)             labelsCount labels: uint32_t size + text
+// the label table and the counts are written by close(); the header of a
+// trace that was not closed has labelsOffset == 0 and its records are
+// counted from the file size
+constexpr std::array<char, 8> traceMagic {{'T', 'S', 'T', 'R', 'A', 'C', 'E', '\0'}};
+constexpr uint32_t traceVersion {3};
+constexpr uint64_t traceDataOffset {4096};
+
+struct traceFileHeader
+{
+  std::array<char, 8> magic {};
+  uint32_t version {};
+  uint32_t recordSize {};
+  uint64_t tscHz {};
+  uint64_t tscMult {};
+  uint32_t tscShift {};
+  // empty start() -> stop() ticks of the thread that opened the trace
+  uint32_t overheadTicks {};
+  uint64_t recordsCount {};
+  uint64_t labelsOffset {};
+  uint64_t labelsCount {};
+  uint32_t processId {};
+};
+
+// the CPUs that read the start and the stop ticks; traceUnknownCpu when
+// the read policy does not tell
+constexpr uint16_t traceUnknownCpu {UINT16_MAX};
+
+struct traceRecord
+{
+  labelId timerId {};
+  labelId startLabel {};
+  labelId stopLabel {};
+  uint16_t startCpu {};
+  uint16_t stopCpu {};
+  uint64_t start {};
+  uint64_t stop {};
+  // kernel thread id of the thread that recorded the span
+  uint32_t threadId {};
+  uint32_t reserved {};
+
+  constexpr
+  bool
+  isCrossCore() const noexcept
+  {
+    return (traceUnknownCpu != startCpu) &&
+           (traceUnknownCpu != stopCpu) &&
+           (startCpu != stopCpu);
+  }
+};
+
+constexpr
+uint16_t
+toTraceCpu(const uint32_t cpu) noexcept
+{
+  return (cpu < traceUnknownCpu) ? static_cast<uint16_t>(cpu) : traceUnknownCpu;
+}
+
+static_assert(sizeof(traceFileHeader) <= traceDataOffset);
+static_assert(sizeof(traceRecord) == 40);
+
+// the kernel id of the calling thread, cached per thread
+uint32_t traceThreadId() noexcept;
+
+////////////////////////////////////////////////////////////////////////////////
+// append-only writer of a binary trace
+// records are stored in a memory-mapped file that grows one chunk at a time;
+// append() reserves a slot with one atomic add and copies the record in the
+// mapping, so several threads can append to the same trace; chunks are never
+// remapped while the trace is open
+class traceWriter final
+{
+ public:
+  static constexpr std::size_t maxChunks {4096};
+
+  // chunkRecords is rounded up to a power of 2 of at least 512 records, so
+  // that the chunks are page aligned
+  explicit traceWriter(const std::string& fileName,
+                       const std::size_t chunkRecords = std::size_t{1} << 20);
+
+  // close() the trace
+  ~traceWriter() noexcept;
+
+  traceWriter(const traceWriter&) = delete;
+  traceWriter& operator=(const traceWriter&) = delete;
+
+  // false when the record is dropped: trace closed, not open or full
+  bool
+  append(const traceRecord& r) noexcept
+  {
+    const uint64_t index {m_next.fetch_add(1, std::memory_order_relaxed)};
+    const uint64_t chunk {index >> m_chunkShift};
+
+    if ( chunk < maxChunks )
+    {
+      traceRecord* base {m_chunks[chunk].load(std::memory_order_acquire)};
+
+      if ( nullptr == base )
+      {
+        base = mapChunk(chunk);
+      }
+      if ( nullptr != base )
+      {
+        base[index & m_chunkMask] = r;
+        return true;
+      }
+    }
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  // write the label table and the counts, unmap and close the file
+  // all the appending threads must be done
+  void close() noexcept;
+
+  bool
+  isOpen() const noexcept
+  {
+    return (m_fd >= 0);
+  }
+
+  uint_fast64_t getRecordsCount() const noexcept;
+
+  uint_fast64_t
+  getDroppedRecords() const noexcept
+  {
+    return m_dropped.load(std::memory_order_relaxed);
+  }
+
+  const std::string&
+  getFileName() const noexcept
+  {
+    return m_fileName;
+  }
+
+ private:
+  const std::string m_fileName;
+  int m_fd {-1};
+  uint_fast32_t m_chunkShift {};
+  uint64_t m_chunkMask {};
+  std::size_t m_chunkBytes {};
+  std::atomic<uint64_t> m_next {0};
+  std::atomic<uint64_t> m_dropped {0};
+  // index of the first record that could not be mapped
+  std::atomic<uint64_t> m_mappedLimit {UINT64_MAX};
+  std::mutex m_mutex {};
+  std::array<std::atomic<traceRecord*>, maxChunks> m_chunks {};
+
+  traceRecord* mapChunk(const uint64_t chunk) noexcept;
+};  // class traceWriter
+
+////////////////////////////////////////////////////////////////////////////////
+// read-only view of a binary trace file
+class traceReader final
+{
+ public:
+  explicit traceReader(const std::string& fileName);
+
+  ~traceReader() noexcept;
+
+  traceReader(const traceReader&) = delete;
+  traceReader& operator=(const traceReader&) = delete;
+
+  // false when the file could not be read or is not a trace; see getError()
+  bool
+  isValid() const noexcept
+  {
+    return m_error.empty();
+  }
+
+  const std::string&
+  getError() const noexcept
+  {
+    return m_error;
+  }
+
+  const traceFileHeader&
+  getHeader() const noexcept
+  {
+    return m_header;
+  }
+
+  tscCalibration getCalibration() const noexcept;
+
+  uint64_t
+  getRecordsCount() const noexcept
+  {
+    return m_recordsCount;
+  }
+
+  const traceRecord&
+  getRecord(const uint64_t i) const noexcept
+  {
+    return m_records[i];
+  }
+
+  // the text of a label id as it was interned by the traced process;
+  // "#<id>" when the trace has no label table
+  std::string getLabel(const labelId id) const;
+
+ private:
+  std::string m_error {};
+  traceFileHeader m_header {};
+  void* m_map {nullptr};
+  std::size_t m_mapSize {0};
+  const traceRecord* m_records {nullptr};
+  uint64_t m_recordsCount {0};
+  std::vector<std::string> m_labels {};
+};  // class traceReader
+
+// per timer and start/stop label pair: count, min, mean, p50, p99, p99.9
+// and max, in ticks and in nsec with the calibration stored in the trace;
+// the cross-core records are counted and left out when keepCrossCore is false
+void writeTraceStatistics(const traceReader& trace,
+                          std::ostream& os,
+                          const bool keepCrossCore = true);
+
+// one line per record:
+// timer,start_label,stop_label,thread,start_cpu,stop_cpu,start_tsc,stop_tsc,ticks,nsec
+void writeTraceCSV(const traceReader& trace, std::ostream& os);
+
+// Chrome Trace Event JSON, loadable in Perfetto or chrome://tracing: one
+// complete ("X") event per record, named after the timer, on the track of
+// its thread, with the labels in the args and timestamps in
+// microseconds since the earliest start; written record by record, so the
+// memory used does not grow with the trace
+void writeTraceChromeJSON(const traceReader& trace, std::ostream& os);
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
@@ -0,0 +1,136 @@
+/*
+ * File:   call_tree.cpp
+ * Author: massimo
+ *
+ * Created on October 18, 2026, 10:15 AM
+ */
+// BEGIN: ignore the warnings listed below when compiled with clang from here
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+////////////////////////////////////////////////////////////////////////////////
+#include "call_tree.h"
+#include <algorithm>
+#include <mutex>
+#include <string>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+namespace
+{
+// guards the children lists of all the trees and the list of the roots
+std::mutex callTreeMutex {};
+std::vector<std::unique_ptr<callTreeNode>> callTreeRoots {};
+}  // namespace
+
+struct callTreeMerger final
+{
+  static
+  void
+  merge(callTreeStatistics& to, const callTreeNode& from)
+  {
+    to.calls += from.getCalls();
+    to.inclusive += from.getInclusiveTicks();
+    // a zone can be left while its children are read: never underflow
+    to.exclusive += from.getInclusiveTicks() - std::min(from.getInclusiveTicks(), from.getChildrenTicks());
+
+    for (auto&& c : from.m_children)
+    {
+      auto&& it = std::find_if(to.children.begin(), to.children.end(), [&c] (auto&& s)
+      {
+        return s.zone == c->getZone();
+      });
+
+      if ( to.children.end() == it )
+      {
+        to.children.push_back(callTreeStatistics{c->getZone(), 0, 0, 0, {}});
+        it = to.children.end() - 1;
+      }
+      merge(*it, *c);
+    }
+  }
+};
+
+callTreeNode&
+callTreeNode::threadRoot()
+{
+  static thread_local callTreeNode* root {nullptr};
+
+  if ( nullptr == root )
+  {
+    std::lock_guard<std::mutex> lock {callTreeMutex};
+
+    callTreeRoots.push_back(std::make_unique<callTreeNode>(nullptr, nullptr));
+    root = callTreeRoots.back().get();
+  }
+  return *root;
+}
+
+callTreeNode&
+callTreeNode::addChild(const zoneDescriptor& zone)
+{
+  std::lock_guard<std::mutex> lock {callTreeMutex};
+
+  m_children.push_back(std::make_unique<callTreeNode>(&zone, this));
+
+  return *m_children.back();
+}
+
+callTreeStatistics
+mergeCallTrees()
+{
+  callTreeStatistics&& root {};
+  std::lock_guard<std::mutex> lock {callTreeMutex};
+
+  for (auto&& r : callTreeRoots)
+  {
+    callTreeMerger::merge(root, *r);
+  }
+  // the roots are never entered: no calls and nothing exclusive
+  root.calls = 0;
+  root.inclusive = 0;
+  root.exclusive = 0;
+  for (auto&& c : root.children)
+  {
+    root.inclusive += c.inclusive;
+  }
+
+  return root;
+}
+
+namespace
+{
+void
+dumpNode(std::ostream& os, callTreeStatistics& node, const std::size_t depth)
+{
+  std::sort(node.children.begin(), node.children.end(), [] (auto&& a, auto&& b)
+  {
+    return a.inclusive > b.inclusive;
+  });
+
+  for (auto&& c : node.children)
+  {
+    os << std::string(2 * depth, ' ')
+       << c.zone->getName() << ": "
+       << c.calls << " calls: inclusive " << c.inclusive
+       << " exclusive " << c.exclusive
+       << " ticks [ inclusive " << tsc_clock::toNanoseconds(c.inclusive)
+       << " exclusive " << tsc_clock::toNanoseconds(c.exclusive)
+       << " nsec ]"
+       << '\n';
+    dumpNode(os, c, depth + 1);
+  }
+}
+}  // namespace
+
+void
+dumpCallTree(std::ostream& os)
+{
+  callTreeStatistics&& root = mergeCallTrees();
+
+  dumpNode(os, root, 0);
+}
+}  // namespace timeSupport
+////////////////////////////////////////////////////////////////////////////////
+#pragma clang diagnostic pop
+// END: ignore the warnings when compiled with clang up to here
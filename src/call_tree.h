@@ -0,0 +1,173 @@
+/*
+ * File:   call_tree.h
+ * Author: massimo
+ *
+ * Created on October 18, 2026, 10:15 AM
+ */
+#pragma once
+
+#include "time_zones.h"
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+// a node of a thread's call tree of nested zones
+// every thread has its own tree and a pointer to the node of the innermost
+// zone it is in: entering a zone moves to (and on the first visit creates) the
+// child node of that zone, leaving it adds the lapsed ticks to the node and
+// to its parent's children ticks, so exclusive = inclusive - children
+// the counters have a single writer, the owning thread; nodes are only added
+// under a lock and never removed, so the trees can be merged while recorded
+// and outlive their threads
+class callTreeNode final
+{
+ public:
+  callTreeNode(const zoneDescriptor* zone, callTreeNode* parent) noexcept
+  :
+  m_zone{zone},
+  m_parent{parent}
+  {}
+
+  callTreeNode(const callTreeNode&) = delete;
+  callTreeNode& operator=(const callTreeNode&) = delete;
+
+  // move the calling thread into the child node of zone
+  static
+  callTreeNode&
+  enter(const zoneDescriptor& zone)
+  {
+    callTreeNode* parent {(nullptr != m_current) ? m_current : &threadRoot()};
+    callTreeNode* node {nullptr};
+
+    for (auto&& c : parent->m_children)
+    {
+      if ( &zone == c->m_zone )
+      {
+        node = c.get();
+        break;
+      }
+    }
+    if ( nullptr == node )
+    {
+      node = &parent->addChild(zone);
+    }
+    m_current = node;
+
+    return *node;
+  }
+
+  // account ticks to the node and move the calling thread back to its parent
+  void
+  leave(const uint_fast64_t ticks) noexcept
+  {
+    m_calls.store(m_calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    m_inclusive.store(m_inclusive.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+    m_parent->m_childrenTicks.store(m_parent->m_childrenTicks.load(std::memory_order_relaxed) + ticks,
+                                    std::memory_order_relaxed);
+    m_current = m_parent;
+  }
+
+  const zoneDescriptor*
+  getZone() const noexcept
+  {
+    return m_zone;
+  }
+
+  uint_fast64_t
+  getCalls() const noexcept
+  {
+    return m_calls.load(std::memory_order_relaxed);
+  }
+
+  uint_fast64_t
+  getInclusiveTicks() const noexcept
+  {
+    return m_inclusive.load(std::memory_order_relaxed);
+  }
+
+  uint_fast64_t
+  getChildrenTicks() const noexcept
+  {
+    return m_childrenTicks.load(std::memory_order_relaxed);
+  }
+
+ private:
+  inline static thread_local callTreeNode* m_current {nullptr};
+  const zoneDescriptor* const m_zone;
+  callTreeNode* const m_parent;
+  std::atomic<uint_fast64_t> m_calls {0};
+  std::atomic<uint_fast64_t> m_inclusive {0};
+  std::atomic<uint_fast64_t> m_childrenTicks {0};
+  std::vector<std::unique_ptr<callTreeNode>> m_children {};
+
+  // the root of the calling thread's tree, created on its first zone
+  static callTreeNode& threadRoot();
+
+  callTreeNode& addChild(const zoneDescriptor& zone);
+
+  friend struct callTreeMerger;
+};  // class callTreeNode
+
+////////////////////////////////////////////////////////////////////////////////
+// times the rest of the scope as a node of the calling thread's call tree;
+// the zone's flat statistics get the inclusive ticks too
+class nestedZoneGuard final
+{
+ public:
+  explicit
+  nestedZoneGuard(zoneDescriptor& zone)
+  :
+  m_zone(zone),
+  m_node(callTreeNode::enter(zone)),
+  m_start{startTSC()}
+  {}
+
+  ~nestedZoneGuard() noexcept
+  {
+    const uint_fast64_t ticks {stopTSC() - m_start};
+
+    m_node.leave(ticks);
+    m_zone.record(ticks);
+  }
+
+  nestedZoneGuard(const nestedZoneGuard&) = delete;
+  nestedZoneGuard& operator=(const nestedZoneGuard&) = delete;
+
+ private:
+  zoneDescriptor& m_zone;
+  callTreeNode& m_node;
+  const uint_fast64_t m_start;
+};  // class nestedZoneGuard
+
+// a node of the call tree merged over all the threads; the nodes of the
+// same zone reached through the same path are summed
+struct callTreeStatistics
+{
+  const zoneDescriptor* zone {nullptr};
+  uint_fast64_t calls {};
+  uint_fast64_t inclusive {};
+  uint_fast64_t exclusive {};
+  std::vector<callTreeStatistics> children {};
+};
+
+// merge the call trees of all the threads; the root has no zone and its
+// children are the outermost zones
+callTreeStatistics mergeCallTrees();
+
+// the merged call tree, one indented line per node with calls, inclusive and
+// exclusive ticks and nsec, the children with the largest inclusive first
+void dumpCallTree(std::ostream& os = std::cout);
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
+
+// time the rest of the enclosing scope as a node of the calling thread's
+// call tree, nested in the enclosing TIME_NESTED_ZONE() if any
+#define TIME_NESTED_ZONE(name)                                                   \
+  static ::timeSupport::zoneDescriptor TS_ZONE_CONCAT(tsZone_, __LINE__)         \
+    {name, __FILE__, __LINE__};                                                  \
+  const ::timeSupport::nestedZoneGuard TS_ZONE_CONCAT(tsZoneGuard_, __LINE__)    \
+    {TS_ZONE_CONCAT(tsZone_, __LINE__)}
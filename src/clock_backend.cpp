@@ -0,0 +1,116 @@
+/*
+ * File:   clock_backend.cpp
+ * Author: massimo
+ *
+ * Created on October 21, 2026, 2:50 PM
+ */
+// BEGIN: ignore the warnings listed below when compiled with clang from here
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+////////////////////////////////////////////////////////////////////////////////
+#include "clock_backend.h"
+#include <cpuid.h>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+namespace
+{
+constexpr unsigned int invariantTSCBit {1u << 8};
+constexpr unsigned int rdtscpBit {1u << 27};
+
+void
+setClockBackend(const clockBackend b) noexcept
+{
+  clockBackendState.store(static_cast<int>(b), std::memory_order_relaxed);
+}
+
+// choose the backend when the process starts, not at the first read
+[[maybe_unused]]
+const clockBackend startupClockBackend {selectClockBackend()};
+}  // namespace
+
+const char*
+clockBackendName(const clockBackend b) noexcept
+{
+  return (clockBackend::TSC == b) ? "tsc" : "monotonic_raw";
+}
+
+clockSupport
+detectClockSupport()
+{
+  clockSupport&& s {};
+  unsigned int eax {};
+  unsigned int ebx {};
+  unsigned int ecx {};
+  unsigned int edx {};
+
+  if ( (0 != __get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx)) && (eax >= 0x80000007) )
+  {
+    __get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx);
+    s.rdtscp = 0 != (edx & rdtscpBit);
+    __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    s.invariantTSC = 0 != (edx & invariantTSCBit);
+  }
+
+  std::ifstream f {"/sys/devices/system/clocksource/clocksource0/current_clocksource"};
+
+  std::getline(f, s.clocksource);
+
+  return s;
+}
+
+clockBackend
+selectClockBackend() noexcept
+{
+  const char* forced {std::getenv("TIME_SUPPORT_CLOCK")};
+  clockBackend b {clockBackend::TSC};
+
+  if ( (nullptr != forced) && (0 == std::strcmp(forced, "tsc")) )
+  {
+    b = clockBackend::TSC;
+  }
+  else if ( (nullptr != forced) && (0 == std::strcmp(forced, "monotonic_raw")) )
+  {
+    b = clockBackend::MONOTONIC_RAW;
+  }
+  else
+  {
+    try
+    {
+      b = detectClockSupport().isTSCReliable() ? clockBackend::TSC : clockBackend::MONOTONIC_RAW;
+    }
+    catch (...)
+    {
+      b = clockBackend::MONOTONIC_RAW;
+    }
+  }
+  setClockBackend(b);
+
+  return b;
+}
+
+void
+forceClockBackend(const clockBackend b) noexcept
+{
+  setClockBackend(b);
+}
+
+void
+writeClockSupport(std::ostream& os)
+{
+  const clockSupport&& s = detectClockSupport();
+
+  os << "clock backend: " << clockBackendName(activeClockBackend())
+     << " (invariant TSC: " << (s.invariantTSC ? "yes" : "no")
+     << ", rdtscp: " << (s.rdtscp ? "yes" : "no")
+     << ", clocksource: " << (s.clocksource.empty() ? "unknown" : s.clocksource)
+     << ")"
+     << '\n';
+}
+}  // namespace timeSupport
+////////////////////////////////////////////////////////////////////////////////
+#pragma clang diagnostic pop
+// END: ignore the warnings when compiled with clang up to here
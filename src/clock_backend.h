@@ -0,0 +1,103 @@
+/*
+ * File:   clock_backend.h
+ * Author: massimo
+ *
+ * Created on October 21, 2026, 2:50 PM
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <iostream>
+#include <string>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+// the clock behind every timer read
+//   TSC            rdtsc/rdtscp: ticks of the invariant TSC
+//   MONOTONIC_RAW  clock_gettime(CLOCK_MONOTONIC_RAW) through the vDSO: the
+//                  ticks are nanoseconds and the calibration is the identity
+enum class clockBackend : int { TSC, MONOTONIC_RAW };
+
+const char* clockBackendName(const clockBackend b) noexcept;
+
+// what the CPU and the kernel say about the TSC
+struct clockSupport
+{
+  // cpuid 0x80000007 edx[8]: constant rate in all P-, C- and T-states
+  bool invariantTSC {false};
+  // cpuid 0x80000001 edx[27]
+  bool rdtscp {false};
+  // /sys/devices/system/clocksource/clocksource0/current_clocksource, empty
+  // when it cannot be read
+  std::string clocksource {};
+
+  // invariant, with rdtscp, and the clocksource of the kernel when known: the
+  // kernel switches away from the TSC when its watchdog finds it unstable
+  bool
+  isTSCReliable() const noexcept
+  {
+    return invariantTSC && rdtscp && (clocksource.empty() || ("tsc" == clocksource));
+  }
+};
+
+clockSupport detectClockSupport();
+
+// choose the backend: TIME_SUPPORT_CLOCK=tsc or TIME_SUPPORT_CLOCK=monotonic_raw
+// forces it, otherwise it is the TSC when reliable; done once at startup
+// (or at the first read, whichever is first), call it again to choose anew
+clockBackend selectClockBackend() noexcept;
+
+// force the backend, e.g. to test the fallback; the measurement overhead and
+// the samples taken so far belong to the previous backend: force it before
+// timing anything
+void forceClockBackend(const clockBackend b) noexcept;
+
+// writes the backend in use and the clock support detected
+void writeClockSupport(std::ostream& os = std::cout);
+
+// the state read by the timers: -1 until the backend is selected, then the
+// clockBackend value
+inline std::atomic<int> clockBackendState {-1};
+
+// true when the reads use the TSC; a relaxed load and a branch always taken
+// in the common case
+inline
+bool
+usingTSC() noexcept
+{
+  const int s {clockBackendState.load(std::memory_order_relaxed)};
+
+  if ( __builtin_expect(static_cast<int>(clockBackend::TSC) == s, 1) )
+  {
+    return true;
+  }
+  if ( s < 0 )
+  {
+    return clockBackend::TSC == selectClockBackend();
+  }
+  return false;
+}
+
+inline
+clockBackend
+activeClockBackend() noexcept
+{
+  return usingTSC() ? clockBackend::TSC : clockBackend::MONOTONIC_RAW;
+}
+
+// the fallback read, in nanoseconds
+inline
+uint_fast64_t
+monotonicRawTicks() noexcept
+{
+  timespec ts {};
+
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+
+  return (static_cast<uint_fast64_t>(ts.tv_sec) * 1'000'000'000) +
+         static_cast<uint_fast64_t>(ts.tv_nsec);
+}
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
@@ -0,0 +1,136 @@
+/*
+ * File:   compact_timer.cpp
+ * Author: massimo
+ *
+ * Created on October 25, 2026, 11:05 AM
+ */
+#include "compact_timer.h"
+#include <algorithm>
+#include <string>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+compactTimer&
+compactTimer::report(std::ostream& os)
+{
+  if ( rdtscTimerStatus::STOPPED == getTimerStatus() )
+  {
+    rdtscTimer::writeReport(os,
+                            labelName(m_name),
+                            labelName(m_startLabel),
+                            labelName(m_stopLabel),
+                            m_start,
+                            m_stop,
+                            rdtscTimer::getMeasurementOverhead(),
+                            m_startCpu,
+                            m_stopCpu);
+    m_status = static_cast<uint8_t>(rdtscTimerStatus::REPORTED);
+  }
+  return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+compactTimerArray::compactTimerArray(const std::size_t size, const timeLabel name)
+:
+m_name{name.getId()}
+{
+  resize(size);
+}
+
+void
+compactTimerArray::resize(const std::size_t size)
+{
+  m_start.resize(size, 0);
+  m_stop.resize(size, 0);
+  m_startLabel.resize(size, noLabel);
+  m_stopLabel.resize(size, noLabel);
+  m_startCpu.resize(size, unknownCpu);
+  m_stopCpu.resize(size, unknownCpu);
+  m_status.resize(size, static_cast<uint8_t>(rdtscTimerStatus::INACTIVE));
+}
+
+compactTimer
+compactTimerArray::get(const std::size_t i) const noexcept
+{
+  compactTimer t {timeLabel{m_name}};
+
+  t.m_start = m_start[i];
+  t.m_stop = m_stop[i];
+  t.m_startLabel = m_startLabel[i];
+  t.m_stopLabel = m_stopLabel[i];
+  t.m_startCpu = m_startCpu[i];
+  t.m_stopCpu = m_stopCpu[i];
+  t.m_status = m_status[i];
+
+  return t;
+}
+
+void
+compactTimerArray::set(const std::size_t i, const compactTimer& t) noexcept
+{
+  m_start[i] = t.m_start;
+  m_stop[i] = t.m_stop;
+  m_startLabel[i] = t.m_startLabel;
+  m_stopLabel[i] = t.m_stopLabel;
+  m_startCpu[i] = t.m_startCpu;
+  m_stopCpu[i] = t.m_stopCpu;
+  m_status[i] = t.m_status;
+}
+
+std::size_t
+compactTimerArray::report(std::ostream& os)
+{
+  const uint_fast64_t overhead {rdtscTimer::getMeasurementOverhead()};
+  const std::string& name = labelName(m_name);
+  std::string timerName {};
+  std::size_t lines {0};
+
+  for (std::size_t&& i {0}; i < size(); ++i)
+  {
+    if ( rdtscTimerStatus::STOPPED != getTimerStatus(i) )
+    {
+      continue;
+    }
+    timerName.assign(name).append(1, '[').append(std::to_string(i)).append(1, ']');
+    rdtscTimer::writeReport(os,
+                            timerName,
+                            labelName(m_startLabel[i]),
+                            labelName(m_stopLabel[i]),
+                            m_start[i],
+                            m_stop[i],
+                            overhead,
+                            m_startCpu[i],
+                            m_stopCpu[i]);
+    m_status[i] = static_cast<uint8_t>(rdtscTimerStatus::REPORTED);
+    ++lines;
+  }
+  return lines;
+}
+
+tickHistogram
+compactTimerArray::histogram() const
+{
+  tickHistogram h {};
+
+  for (std::size_t&& i {0}; i < size(); ++i)
+  {
+    if ( isStopped(i) )
+    {
+      h.record(m_stop[i] - m_start[i]);
+    }
+  }
+  return h;
+}
+
+std::size_t
+compactTimerArray::count(const rdtscTimerStatus s) const noexcept
+{
+  return static_cast<std::size_t>(std::count(m_status.begin(), m_status.end(), static_cast<uint8_t>(s)));
+}
+
+void
+compactTimerArray::reset() noexcept
+{
+  std::fill(m_status.begin(), m_status.end(), static_cast<uint8_t>(rdtscTimerStatus::INACTIVE));
+}
+}  // namespace timeSupport
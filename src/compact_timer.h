@@ -0,0 +1,260 @@
+/*
+ * File:   compact_timer.h
+ * Author: massimo
+ *
+ * Created on October 25, 2026, 11:05 AM
+ */
+#pragma once
+
+#include "time_support.h"
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+// a timer for large arrays of per-entity timers, e.g. one per connection:
+// the ticks, the CPUs, a state byte and the ids of the name and the labels,
+// trivially copyable and well within a cache line
+// there is no log: a start() of a started timer and a stop() of a timer not
+// started are ignored; reports go to the stream passed to report()
+class compactTimer final
+{
+ public:
+  using rdtscTimerStatus = rdtscTimer::rdtscTimerStatus;
+
+  constexpr compactTimer() noexcept = default;
+
+  constexpr
+  explicit
+  compactTimer(const timeLabel name) noexcept
+  :
+  m_name{name.getId()}
+  {}
+
+  template <typename readPolicy = defaultReadPolicy>
+  compactTimer&
+  start(const timeLabel startPoint = timeLabel{}) noexcept
+  {
+    if ( rdtscTimerStatus::STARTED != getTimerStatus() )
+    {
+      m_status = static_cast<uint8_t>(rdtscTimerStatus::STARTED);
+      m_startLabel = startPoint.getId();
+      m_start = startTSC<readPolicy>(m_startCpu);
+    }
+    return *this;
+  }
+
+  template <typename readPolicy = defaultReadPolicy>
+  compactTimer&
+  stop(const timeLabel stopPoint = timeLabel{}) noexcept
+  {
+    if ( rdtscTimerStatus::STARTED == getTimerStatus() )
+    {
+      m_stop = stopTSC<readPolicy>(m_stopCpu);
+      m_stopLabel = stopPoint.getId();
+      m_status = static_cast<uint8_t>(rdtscTimerStatus::STOPPED);
+    }
+    return *this;
+  }
+
+  // write one line as rdtscTimer::report() does, if stopped
+  compactTimer& report(std::ostream& os = std::cout);
+
+  constexpr
+  rdtscTimerStatus
+  getTimerStatus() const noexcept
+  {
+    return static_cast<rdtscTimerStatus>(m_status);
+  }
+
+  constexpr
+  labelId
+  getNameId() const noexcept
+  {
+    return m_name;
+  }
+
+  constexpr
+  labelId
+  getStartLabelId() const noexcept
+  {
+    return m_startLabel;
+  }
+
+  constexpr
+  labelId
+  getStopLabelId() const noexcept
+  {
+    return m_stopLabel;
+  }
+
+  constexpr
+  uint_fast64_t
+  getStartTSC() const noexcept
+  {
+    return m_start;
+  }
+
+  constexpr
+  uint_fast64_t
+  getStopTSC() const noexcept
+  {
+    return m_stop;
+  }
+
+  constexpr
+  uint32_t
+  getStartCpu() const noexcept
+  {
+    return m_startCpu;
+  }
+
+  constexpr
+  uint32_t
+  getStopCpu() const noexcept
+  {
+    return m_stopCpu;
+  }
+
+  // 0 unless stopped or reported
+  constexpr
+  uint_fast64_t
+  getStopLapsedTSC() const noexcept
+  {
+    return isStopped() ? (m_stop - m_start) : 0;
+  }
+
+  uint_fast64_t
+  getStopLapsed_nsec() const noexcept
+  {
+    return tsc_clock::toNanoseconds(getStopLapsedTSC());
+  }
+
+ private:
+  friend class compactTimerArray;
+
+  uint_fast64_t m_start {};
+  uint_fast64_t m_stop {};
+  labelId m_name {noLabel};
+  labelId m_startLabel {noLabel};
+  labelId m_stopLabel {noLabel};
+  uint32_t m_startCpu {unknownCpu};
+  uint32_t m_stopCpu {unknownCpu};
+  uint8_t m_status {static_cast<uint8_t>(rdtscTimerStatus::INACTIVE)};
+
+  constexpr
+  bool
+  isStopped() const noexcept
+  {
+    return (rdtscTimerStatus::STOPPED == getTimerStatus()) ||
+           (rdtscTimerStatus::REPORTED == getTimerStatus());
+  }
+};  // class compactTimer
+
+static_assert(std::is_trivially_copyable_v<compactTimer>, "compactTimer must be trivially copyable");
+static_assert(sizeof(compactTimer) <= 64, "compactTimer must fit in a cache line");
+
+////////////////////////////////////////////////////////////////////////////////
+// compact timers stored as a structure of arrays: one column per field, so
+// that the bulk operations read only the columns they need, e.g. the
+// aggregates touch the states and the ticks only
+// all the timers share the name of the array; entity i is reported as name[i]
+class compactTimerArray final
+{
+ public:
+  using rdtscTimerStatus = rdtscTimer::rdtscTimerStatus;
+
+  explicit compactTimerArray(const std::size_t size = 0, const timeLabel name = timeLabel{});
+
+  // new timers are inactive
+  void resize(const std::size_t size);
+
+  std::size_t
+  size() const noexcept
+  {
+    return m_status.size();
+  }
+
+  template <typename readPolicy = defaultReadPolicy>
+  void
+  start(const std::size_t i, const timeLabel startPoint = timeLabel{}) noexcept
+  {
+    if ( rdtscTimerStatus::STARTED != getTimerStatus(i) )
+    {
+      m_status[i] = static_cast<uint8_t>(rdtscTimerStatus::STARTED);
+      m_startLabel[i] = startPoint.getId();
+      m_start[i] = startTSC<readPolicy>(m_startCpu[i]);
+    }
+  }
+
+  template <typename readPolicy = defaultReadPolicy>
+  void
+  stop(const std::size_t i, const timeLabel stopPoint = timeLabel{}) noexcept
+  {
+    if ( rdtscTimerStatus::STARTED == getTimerStatus(i) )
+    {
+      m_stop[i] = stopTSC<readPolicy>(m_stopCpu[i]);
+      m_stopLabel[i] = stopPoint.getId();
+      m_status[i] = static_cast<uint8_t>(rdtscTimerStatus::STOPPED);
+    }
+  }
+
+  rdtscTimerStatus
+  getTimerStatus(const std::size_t i) const noexcept
+  {
+    return static_cast<rdtscTimerStatus>(m_status[i]);
+  }
+
+  // 0 unless stopped or reported
+  uint_fast64_t
+  getStopLapsedTSC(const std::size_t i) const noexcept
+  {
+    return isStopped(i) ? (m_stop[i] - m_start[i]) : 0;
+  }
+
+  // timer i as a compactTimer
+  compactTimer get(const std::size_t i) const noexcept;
+
+  // overwrite timer i, the name excepted
+  void set(const std::size_t i, const compactTimer& t) noexcept;
+
+  // one line per stopped timer, as rdtscTimer::report() does; the timers
+  // become reported; returns the lines written
+  std::size_t report(std::ostream& os = std::cout);
+
+  // the lapsed ticks of the stopped and reported timers
+  tickHistogram histogram() const;
+
+  // the timers in state s
+  std::size_t count(const rdtscTimerStatus s) const noexcept;
+
+  // all the timers back to inactive
+  void reset() noexcept;
+
+  const std::string&
+  getName() const noexcept
+  {
+    return labelName(m_name);
+  }
+
+ private:
+  const labelId m_name;
+  std::vector<uint_fast64_t> m_start {};
+  std::vector<uint_fast64_t> m_stop {};
+  std::vector<labelId> m_startLabel {};
+  std::vector<labelId> m_stopLabel {};
+  std::vector<uint32_t> m_startCpu {};
+  std::vector<uint32_t> m_stopCpu {};
+  std::vector<uint8_t> m_status {};
+
+  bool
+  isStopped(const std::size_t i) const noexcept
+  {
+    return (rdtscTimerStatus::STOPPED == getTimerStatus(i)) ||
+           (rdtscTimerStatus::REPORTED == getTimerStatus(i));
+  }
+};  // class compactTimerArray
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
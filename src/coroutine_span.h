@@ -0,0 +1,360 @@
+/*
+ * File:   coroutine_span.h
+ * Author: massimo
+ *
+ * Created on October 27, 2026, 10:20 AM
+ */
+#pragma once
+
+// C++20 coroutines only: with -std=c++17 this header declares nothing
+#if defined(__has_include)
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+#define TIME_SUPPORT_HAS_COROUTINES 1
+#endif
+#endif
+
+// set by the builds that must have them, e.g. the C++20 unit tests
+#if defined(TIME_SUPPORT_REQUIRE_COROUTINES) && !defined(TIME_SUPPORT_HAS_COROUTINES)
+#error "coroutine_span.h: C++20 coroutines are required but not available"
+#endif
+
+#ifdef TIME_SUPPORT_HAS_COROUTINES
+
+#include "labels.h"
+#include "tsc_clock.h"
+#include <coroutine>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+template <typename awaiterType>
+class timedAwaiter;
+
+// times a coroutine as a sequence of active segments: pause() at every
+// suspension, resume() at every resumption
+// the active ticks are summed segment by segment, each read on the thread
+// running that segment, so neither the suspended time nor a resumption on
+// another core leaks into them; the wall ticks go from start() to stop()
+// wrap the awaitables with timed() to pause and resume at every co_await:
+//   span.start(TS_LABEL("REQUEST"));
+//   auto&& reply = co_await timed(span, connection.read());
+//   span.stop(TS_LABEL("REPLY")).report();
+class coroutineSpan final
+{
+ public:
+  explicit
+  coroutineSpan(const timeLabel name = timeLabel{}) noexcept
+  :
+  m_name{name.getId()}
+  {}
+
+  coroutineSpan&
+  start(const timeLabel startPoint = timeLabel{}) noexcept
+  {
+    m_startLabel = startPoint.getId();
+    m_active = 0;
+    m_suspensions = 0;
+    m_migrations = 0;
+    m_crossCoreSegments = 0;
+    m_state = state::ACTIVE;
+    m_start = startTSC(m_startCpu);
+    m_segmentStart = m_start;
+    m_segmentCpu = m_startCpu;
+    return *this;
+  }
+
+  // at a suspension: close the active segment
+  coroutineSpan&
+  pause() noexcept
+  {
+    if ( state::ACTIVE == m_state )
+    {
+      closeSegment();
+      m_state = state::PAUSED;
+      ++m_suspensions;
+    }
+    return *this;
+  }
+
+  // at a resumption, maybe on another thread: open a new active segment
+  coroutineSpan&
+  resume() noexcept
+  {
+    if ( state::PAUSED == m_state )
+    {
+      const uint32_t previousCpu {m_lastCpu};
+
+      m_state = state::ACTIVE;
+      m_segmentStart = startTSC(m_segmentCpu);
+      if ( (unknownCpu != previousCpu) && (unknownCpu != m_segmentCpu) && (previousCpu != m_segmentCpu) )
+      {
+        ++m_migrations;
+      }
+    }
+    return *this;
+  }
+
+  coroutineSpan&
+  stop(const timeLabel stopPoint = timeLabel{}) noexcept
+  {
+    if ( state::ACTIVE == m_state )
+    {
+      closeSegment();
+    }
+    if ( (state::ACTIVE == m_state) || (state::PAUSED == m_state) )
+    {
+      m_stopLabel = stopPoint.getId();
+      m_stop = m_segmentStop;
+      m_stopCpu = m_lastCpu;
+      m_state = state::STOPPED;
+    }
+    return *this;
+  }
+
+  constexpr
+  bool
+  isActive() const noexcept
+  {
+    return state::ACTIVE == m_state;
+  }
+
+  constexpr
+  bool
+  isStopped() const noexcept
+  {
+    return state::STOPPED == m_state;
+  }
+
+  // the ticks of the active segments closed so far
+  constexpr
+  uint_fast64_t
+  getActiveTSC() const noexcept
+  {
+    return m_active;
+  }
+
+  // from start() to stop(); 0 until stopped
+  constexpr
+  uint_fast64_t
+  getWallTSC() const noexcept
+  {
+    return isStopped() ? (m_stop - m_start) : 0;
+  }
+
+  constexpr
+  uint_fast64_t
+  getSuspendedTSC() const noexcept
+  {
+    return (getWallTSC() > m_active) ? (getWallTSC() - m_active) : 0;
+  }
+
+  uint_fast64_t
+  getActive_nsec() const noexcept
+  {
+    return tsc_clock::toNanoseconds(getActiveTSC());
+  }
+
+  uint_fast64_t
+  getWall_nsec() const noexcept
+  {
+    return tsc_clock::toNanoseconds(getWallTSC());
+  }
+
+  constexpr
+  uint_fast64_t
+  getSuspensionsCount() const noexcept
+  {
+    return m_suspensions;
+  }
+
+  // resumptions on a CPU other than the one of the previous segment
+  constexpr
+  uint_fast64_t
+  getMigrationsCount() const noexcept
+  {
+    return m_migrations;
+  }
+
+  // segments whose own start and stop were read on different CPUs
+  constexpr
+  uint_fast64_t
+  getCrossCoreSegmentsCount() const noexcept
+  {
+    return m_crossCoreSegments;
+  }
+
+  // the wall ticks compare the TSCs of two cores
+  constexpr
+  bool
+  isCrossCore() const noexcept
+  {
+    return (unknownCpu != m_startCpu) && (unknownCpu != m_stopCpu) && (m_startCpu != m_stopCpu);
+  }
+
+  // name: start -> stop: active and wall ticks and nsec, suspensions and migrations
+  void
+  report(std::ostream& os = std::cout) const
+  {
+    os << labelName(m_name) << ": "
+       << labelName(m_startLabel) << " -> " << labelName(m_stopLabel)
+       << ": active " << getActiveTSC() << " ticks [ " << getActive_nsec() << " nsec ]"
+       << ", wall " << getWallTSC() << " ticks [ " << getWall_nsec() << " nsec ]"
+       << ", " << m_suspensions << " suspensions, "
+       << m_migrations << " migrations";
+    if ( isCrossCore() )
+    {
+      os << " CROSS-CORE: cpu " << m_startCpu << " -> cpu " << m_stopCpu;
+    }
+    os << '\n';
+  }
+
+ private:
+  template <typename awaiterType>
+  friend class timedAwaiter;
+
+  enum class state : uint8_t { INACTIVE, ACTIVE, PAUSED, STOPPED };
+
+  labelId m_name {noLabel};
+  labelId m_startLabel {noLabel};
+  labelId m_stopLabel {noLabel};
+  uint_fast64_t m_start {};
+  uint_fast64_t m_stop {};
+  uint_fast64_t m_segmentStart {};
+  uint_fast64_t m_segmentStop {};
+  uint_fast64_t m_active {};
+  uint_fast64_t m_suspensions {};
+  uint_fast64_t m_migrations {};
+  uint_fast64_t m_crossCoreSegments {};
+  uint32_t m_startCpu {unknownCpu};
+  uint32_t m_stopCpu {unknownCpu};
+  uint32_t m_segmentCpu {unknownCpu};
+  // the CPU that closed the last segment
+  uint32_t m_lastCpu {unknownCpu};
+  state m_state {state::INACTIVE};
+
+  // the coroutine did not suspend after all: not a suspension
+  void
+  cancelPause() noexcept
+  {
+    if ( state::PAUSED == m_state )
+    {
+      --m_suspensions;
+      m_state = state::ACTIVE;
+      m_segmentStart = startTSC(m_segmentCpu);
+    }
+  }
+
+  void
+  closeSegment() noexcept
+  {
+    m_segmentStop = stopTSC(m_lastCpu);
+    m_active += m_segmentStop - m_segmentStart;
+    if ( (unknownCpu != m_segmentCpu) && (unknownCpu != m_lastCpu) && (m_segmentCpu != m_lastCpu) )
+    {
+      ++m_crossCoreSegments;
+    }
+  }
+};  // class coroutineSpan
+
+////////////////////////////////////////////////////////////////////////////////
+// the awaiter of an awaitable: its operator co_await, if any, or itself
+template <typename A>
+decltype(auto)
+awaiterOf(A&& a)
+{
+  if constexpr ( requires { std::forward<A>(a).operator co_await(); } )
+  {
+    return std::forward<A>(a).operator co_await();
+  }
+  else if constexpr ( requires { operator co_await(std::forward<A>(a)); } )
+  {
+    return operator co_await(std::forward<A>(a));
+  }
+  else
+  {
+    return std::forward<A>(a);
+  }
+}
+
+// an lvalue awaiter is referenced, any other one is moved in
+template <typename A>
+using awaiterStorage = std::conditional_t<std::is_lvalue_reference_v<decltype(awaiterOf(std::declval<A>()))>,
+                                          decltype(awaiterOf(std::declval<A>())),
+                                          std::remove_cvref_t<decltype(awaiterOf(std::declval<A>()))>>;
+
+// forwards to the awaiter of an awaitable, pausing the span before the
+// coroutine suspends and resuming it when the coroutine runs again
+template <typename awaiterType>
+class timedAwaiter final
+{
+ public:
+  template <typename A>
+  timedAwaiter(coroutineSpan& span, A&& a)
+  :
+  m_span(span),
+  m_awaiter(awaiterOf(std::forward<A>(a)))
+  {}
+
+  bool
+  await_ready()
+  {
+    return m_awaiter.await_ready();
+  }
+
+  // pause before the inner await_suspend(): once it has handed the coroutine
+  // over, another thread may already be resuming it
+  template <typename promise>
+  auto
+  await_suspend(std::coroutine_handle<promise> h)
+  {
+    using resultType = decltype(m_awaiter.await_suspend(h));
+
+    m_span.pause();
+    if constexpr ( std::is_void_v<resultType> )
+    {
+      m_awaiter.await_suspend(h);
+    }
+    else if constexpr ( std::is_same_v<resultType, bool> )
+    {
+      const bool suspended {m_awaiter.await_suspend(h)};
+
+      // not suspended after all: the coroutine goes on
+      if ( !suspended )
+      {
+        m_span.cancelPause();
+      }
+      return suspended;
+    }
+    else
+    {
+      return m_awaiter.await_suspend(h);
+    }
+  }
+
+  decltype(auto)
+  await_resume()
+  {
+    m_span.resume();
+    return m_awaiter.await_resume();
+  }
+
+ private:
+  coroutineSpan& m_span;
+  awaiterType m_awaiter;
+};  // class timedAwaiter
+
+// co_await timed(span, awaitable): co_await awaitable with the span paused
+// while the coroutine is suspended
+template <typename A>
+timedAwaiter<awaiterStorage<A>>
+timed(coroutineSpan& span, A&& a)
+{
+  return timedAwaiter<awaiterStorage<A>>{span, std::forward<A>(a)};
+}
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
+
+#endif  // TIME_SUPPORT_HAS_COROUTINES
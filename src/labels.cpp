@@ -0,0 +1,116 @@
+/*
+ * File:   labels.cpp
+ * Author: massimo
+ *
+ * Created on October 16, 2026, 2:05 PM
+ */
+// BEGIN: ignore the warnings listed below when compiled with clang from here
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+////////////////////////////////////////////////////////////////////////////////
+#include "labels.h"
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+namespace
+{
+class labelTable final
+{
+ public:
+  labelTable()
+  {
+    // id 0 is the empty label
+    m_names.emplace_back();
+    m_ids.emplace(m_names.back(), noLabel);
+  }
+
+  labelId
+  intern(const std::string_view label)
+  {
+    {
+      std::shared_lock<std::shared_mutex> lock {m_mutex};
+      auto&& it = m_ids.find(label);
+
+      if ( m_ids.end() != it )
+      {
+        return it->second;
+      }
+    }
+
+    std::unique_lock<std::shared_mutex> lock {m_mutex};
+    auto&& it = m_ids.find(label);
+
+    if ( m_ids.end() != it )
+    {
+      return it->second;
+    }
+
+    // the deque never moves its strings, so the views used as keys stay valid
+    m_names.emplace_back(label);
+    const labelId id {static_cast<labelId>(m_names.size() - 1)};
+    m_ids.emplace(m_names.back(), id);
+
+    return id;
+  }
+
+  const std::string&
+  name(const labelId id) const noexcept
+  {
+    std::shared_lock<std::shared_mutex> lock {m_mutex};
+
+    if ( id < m_names.size() )
+    {
+      return m_names[id];
+    }
+    return m_names.front();
+  }
+
+  std::size_t
+  size() const noexcept
+  {
+    std::shared_lock<std::shared_mutex> lock {m_mutex};
+
+    return m_names.size();
+  }
+
+ private:
+  mutable std::shared_mutex m_mutex {};
+  std::deque<std::string> m_names {};
+  std::unordered_map<std::string_view, labelId> m_ids {};
+};  // class labelTable
+
+labelTable&
+table()
+{
+  static labelTable t {};
+
+  return t;
+}
+}  // namespace
+
+labelId
+internLabel(const std::string_view label)
+{
+  return table().intern(label);
+}
+
+const std::string&
+labelName(const labelId id) noexcept
+{
+  return table().name(id);
+}
+
+std::size_t
+internedLabelsCount() noexcept
+{
+  return table().size();
+}
+}  // namespace timeSupport
+////////////////////////////////////////////////////////////////////////////////
+#pragma clang diagnostic pop
+// END: ignore the warnings when compiled with clang up to here
@@ -0,0 +1,106 @@
+/*
+ * File:   labels.h
+ * Author: massimo
+ *
+ * Created on October 16, 2026, 2:05 PM
+ */
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+// labels (timer names, start and stop points) are interned in a global
+// table and then referenced by their id; the strings are looked up only
+// when something has to be written
+using labelId = uint32_t;
+
+// the id of the empty label
+constexpr labelId noLabel {0};
+
+// return the id of the label, adding it to the table on first use
+// thread-safe; looking up an already interned label does not allocate
+labelId internLabel(const std::string_view label);
+
+// return the text of an interned label; thread-safe
+// the reference stays valid until the end of the program
+const std::string& labelName(const labelId id) noexcept;
+
+// number of labels interned so far, the empty label included
+std::size_t internedLabelsCount() noexcept;
+
+////////////////////////////////////////////////////////////////////////////////
+// a start/stop point label passed around by id
+// the converting ctors intern the text: a lookup in the label table without
+// allocation once the text is known; use TS_LABEL() to intern a literal only
+// once per call site
+class timeLabel final
+{
+ public:
+  constexpr timeLabel() noexcept = default;
+
+  constexpr
+  explicit
+  timeLabel(const labelId id) noexcept
+  :
+  m_id{id}
+  {}
+
+  timeLabel(const char* label)
+  :
+  m_id{internLabel(label)}
+  {}
+
+  timeLabel(const std::string& label)
+  :
+  m_id{internLabel(label)}
+  {}
+
+  timeLabel(const std::string_view label)
+  :
+  m_id{internLabel(label)}
+  {}
+
+  constexpr
+  labelId
+  getId() const noexcept
+  {
+    return m_id;
+  }
+
+  const std::string&
+  getName() const noexcept
+  {
+    return labelName(m_id);
+  }
+
+  constexpr
+  bool
+  empty() const noexcept
+  {
+    return noLabel == m_id;
+  }
+
+ private:
+  labelId m_id {noLabel};
+};  // class timeLabel
+
+inline
+std::ostream&
+operator<<(std::ostream& os, const timeLabel& obj)
+{
+  return os << obj.getName();
+}
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
+
+// intern a label the first time the call site runs, then reuse its id
+#define TS_LABEL(text) \
+  ([] () noexcept -> ::timeSupport::timeLabel \
+   { \
+     static const ::timeSupport::timeLabel label {text}; \
+     return label; \
+   }())
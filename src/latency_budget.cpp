@@ -0,0 +1,251 @@
+/*
+ * File:   latency_budget.cpp
+ * Author: massimo
+ *
+ * Created on October 23, 2026, 9:40 AM
+ */
+#include "latency_budget.h"
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+namespace
+{
+void
+writeCpu(std::ostream& os, const uint32_t cpu)
+{
+  if ( unknownCpu == cpu )
+  {
+    os << '?';
+  }
+  else
+  {
+    os << cpu;
+  }
+}
+}  // namespace
+
+std::ostream& operator<<(std::ostream& os, const budgetExemplar& obj)
+{
+  os << labelName(obj.timerId) << ": "
+     << labelName(obj.startLabel) << " -> " << labelName(obj.stopLabel)
+     << ": " << obj.ticks() << " ticks over a budget of " << obj.budget << " ticks"
+     << " (thread " << obj.threadId << ", cpu ";
+  writeCpu(os, obj.startCpu);
+  os << " -> ";
+  writeCpu(os, obj.stopCpu);
+
+  return os << ')';
+}
+
+std::ostream& operator<<(std::ostream& os, const stalledRegion& obj)
+{
+  os << labelName(obj.timerId) << ": "
+     << labelName(obj.startLabel) << " -> STALLED"
+     << ": running for " << obj.ticks() << " ticks past a deadline of "
+     << (obj.deadline - obj.start) << " ticks"
+     << " (thread " << obj.threadId << ", cpu ";
+  writeCpu(os, obj.startCpu);
+
+  return os << ')';
+}
+
+////////////////////////////////////////////////////////////////////////////////
+exemplarLog::exemplarLog(const std::size_t capacity)
+:
+m_capacity{(0 == capacity) ? 1 : capacity}
+{
+  m_exemplars.reserve(m_capacity);
+}
+
+void
+exemplarLog::record(const budgetExemplar& e)
+{
+  std::lock_guard<std::mutex> lock {m_mutex};
+
+  if ( m_exemplars.size() < m_capacity )
+  {
+    m_exemplars.push_back(e);
+  }
+  else
+  {
+    m_exemplars[m_next] = e;
+  }
+  m_next = (m_next + 1) % m_capacity;
+  ++m_recorded;
+}
+
+std::vector<budgetExemplar>
+exemplarLog::snapshot() const
+{
+  std::lock_guard<std::mutex> lock {m_mutex};
+  std::vector<budgetExemplar> exemplars {};
+
+  exemplars.reserve(m_exemplars.size());
+  // m_next is the oldest one once the log is full
+  const std::size_t first {(m_exemplars.size() < m_capacity) ? 0 : m_next};
+
+  for (std::size_t&& i {0}; i < m_exemplars.size(); ++i)
+  {
+    exemplars.push_back(m_exemplars[(first + i) % m_exemplars.size()]);
+  }
+  return exemplars;
+}
+
+uint_fast64_t
+exemplarLog::getRecordedCount() const noexcept
+{
+  std::lock_guard<std::mutex> lock {m_mutex};
+
+  return m_recorded;
+}
+
+void
+exemplarLog::report(std::ostream& os) const
+{
+  for (auto&& e : snapshot())
+  {
+    os << e << '\n';
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+deadlineWatchdog::deadlineWatchdog(stallCallback onStall, const std::chrono::milliseconds& period)
+:
+m_onStall{std::move(onStall)},
+m_period{period}
+{
+  m_watchdog = std::thread(&deadlineWatchdog::watchdogLoop, this);
+}
+
+deadlineWatchdog::~deadlineWatchdog() noexcept
+{
+  {
+    std::lock_guard<std::mutex> lock {m_mutex};
+
+    m_stopRequested = true;
+  }
+  m_wakeUp.notify_one();
+  if ( m_watchdog.joinable() )
+  {
+    m_watchdog.join();
+  }
+}
+
+deadlineWatchdog::slot*
+deadlineWatchdog::acquire(const labelId timerId)
+{
+  std::lock_guard<std::mutex> lock {m_slotsMutex};
+  slot* s {nullptr};
+
+  if ( m_freeSlots.empty() )
+  {
+    m_slots.push_back(std::make_unique<slot>());
+    s = m_slots.back().get();
+  }
+  else
+  {
+    s = m_freeSlots.back();
+    m_freeSlots.pop_back();
+  }
+  s->m_timerId = timerId;
+
+  return s;
+}
+
+void
+deadlineWatchdog::release(slot* s) noexcept
+{
+  if ( nullptr == s )
+  {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock {m_slotsMutex};
+
+  s->end();
+  m_freeSlots.push_back(s);
+}
+
+std::size_t
+deadlineWatchdog::getWatchedCount() const
+{
+  std::lock_guard<std::mutex> lock {m_slotsMutex};
+
+  return m_slots.size() - m_freeSlots.size();
+}
+
+std::size_t
+deadlineWatchdog::scan()
+{
+  std::vector<stalledRegion> stalls {};
+
+  {
+    std::lock_guard<std::mutex> lock {m_slotsMutex};
+    const uint_fast64_t now {stopTSC()};
+
+    for (auto&& s : m_slots)
+    {
+      const uint_fast64_t deadline {s->m_deadline.load(std::memory_order_acquire)};
+
+      if ( (0 == deadline) || (now <= deadline) )
+      {
+        continue;
+      }
+
+      const uint_fast64_t seq {s->m_seq.load(std::memory_order_relaxed)};
+
+      if ( seq == s->m_flaggedSeq )
+      {
+        continue;
+      }
+
+      stalledRegion r {s->m_timerId,
+                       s->m_startLabel.load(std::memory_order_relaxed),
+                       s->m_start.load(std::memory_order_relaxed),
+                       deadline,
+                       now,
+                       s->m_threadId.load(std::memory_order_relaxed),
+                       s->m_startCpu.load(std::memory_order_relaxed)};
+
+      // the run ended, or ended and started again, while it was read
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if ( (deadline != s->m_deadline.load(std::memory_order_relaxed)) ||
+           (seq != s->m_seq.load(std::memory_order_relaxed)) )
+      {
+        continue;
+      }
+      s->m_flaggedSeq = seq;
+      stalls.push_back(r);
+    }
+  }
+  m_scans.fetch_add(1, std::memory_order_relaxed);
+  m_stalls.fetch_add(stalls.size(), std::memory_order_relaxed);
+
+  // called without the lock: the callback may attach or detach timers
+  if ( m_onStall )
+  {
+    for (auto&& r : stalls)
+    {
+      m_onStall(r);
+    }
+  }
+  return stalls.size();
+}
+
+void
+deadlineWatchdog::watchdogLoop()
+{
+  std::unique_lock<std::mutex> lock {m_mutex};
+
+  for (;;)
+  {
+    if ( m_wakeUp.wait_for(lock, m_period, [this] () { return m_stopRequested; }) )
+    {
+      return;
+    }
+    lock.unlock();
+    scan();
+    lock.lock();
+  }
+}
+}  // namespace timeSupport
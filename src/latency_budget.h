@@ -0,0 +1,225 @@
+/*
+ * File:   latency_budget.h
+ * Author: massimo
+ *
+ * Created on October 23, 2026, 9:40 AM
+ */
+#pragma once
+
+#include "labels.h"
+#include "tsc_clock.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+// a region that ran over the budget of its timer, as seen by stop()
+struct budgetExemplar
+{
+  labelId timerId {};
+  labelId startLabel {};
+  labelId stopLabel {};
+  uint_fast64_t start {};
+  uint_fast64_t stop {};
+  uint_fast64_t budget {};
+  // the traceThreadId() of the thread that stopped the timer
+  uint32_t threadId {};
+  uint32_t startCpu {unknownCpu};
+  uint32_t stopCpu {unknownCpu};
+
+  constexpr
+  uint_fast64_t
+  ticks() const noexcept
+  {
+    return stop - start;
+  }
+};
+
+// timer: start -> stop: ticks over a budget of ticks (thread, cpus)
+std::ostream& operator<<(std::ostream& os, const budgetExemplar& obj);
+
+// called by stop() on the timer's thread, only for the regions over budget
+using budgetCallback = std::function<void(const budgetExemplar&)>;
+
+////////////////////////////////////////////////////////////////////////////////
+// keeps the last exemplars of the regions over budget, for any number of
+// timers and threads; recording takes a lock, but only the slow regions pay it
+//   exemplarLog slow {};
+//   t.setBudget(tsc_clock::toTicks(std::chrono::microseconds(500)), slow.recorder());
+class exemplarLog final
+{
+ public:
+  explicit exemplarLog(const std::size_t capacity = 64);
+
+  exemplarLog(const exemplarLog&) = delete;
+  exemplarLog& operator=(const exemplarLog&) = delete;
+
+  // keep e, replacing the oldest exemplar when the log is full
+  void record(const budgetExemplar& e);
+
+  // a callback recording into this log, which must outlive the timers using it
+  budgetCallback
+  recorder() noexcept
+  {
+    return [this] (const budgetExemplar& e) { record(e); };
+  }
+
+  // the kept exemplars, the oldest first
+  std::vector<budgetExemplar> snapshot() const;
+
+  // the exemplars recorded since the log was created, kept or not
+  uint_fast64_t getRecordedCount() const noexcept;
+
+  // one line per kept exemplar, the oldest first
+  void report(std::ostream& os) const;
+
+ private:
+  const std::size_t m_capacity;
+  mutable std::mutex m_mutex {};
+  std::vector<budgetExemplar> m_exemplars {};
+  std::size_t m_next {0};
+  uint_fast64_t m_recorded {0};
+};  // class exemplarLog
+
+////////////////////////////////////////////////////////////////////////////////
+// a region still running past its deadline, as seen by the watchdog
+struct stalledRegion
+{
+  labelId timerId {};
+  labelId startLabel {};
+  uint_fast64_t start {};
+  uint_fast64_t deadline {};
+  // the TSC when the watchdog found the region running
+  uint_fast64_t now {};
+  // the traceThreadId() of the thread that started the timer
+  uint32_t threadId {};
+  uint32_t startCpu {unknownCpu};
+
+  constexpr
+  uint_fast64_t
+  ticks() const noexcept
+  {
+    return now - start;
+  }
+};
+
+// timer: start -> STALLED: running for ticks past a deadline of ticks (thread, cpu)
+std::ostream& operator<<(std::ostream& os, const stalledRegion& obj);
+
+////////////////////////////////////////////////////////////////////////////////
+// flags the timed regions still running past their deadline, while they run:
+// a timer attached with watchWith() publishes the start and the deadline
+// (start + budget) of every run into its own slot, and a background thread
+// scans the slots every period; a stalled run is passed to onStall once, on
+// the watchdog's thread, however long it runs
+// start() pays a few relaxed stores and stop() one store; the slots are
+// read without locks or fences on the timers' side
+// the watchdog must outlive the timers attached to it
+class deadlineWatchdog final
+{
+ public:
+  // the slot of one timer: written by the thread running the timer, read by
+  // the watchdog; a run is identified by its sequence number, so that a
+  // scan racing with stop() and the next start() can tell the runs apart
+  class alignas(64) slot final
+  {
+   public:
+    void
+    begin(const uint_fast64_t start,
+          const uint_fast64_t budget,
+          const labelId startLabel,
+          const uint32_t threadId,
+          const uint32_t startCpu) noexcept
+    {
+      const uint_fast64_t deadline {(budget > (UINT_FAST64_MAX - start)) ? UINT_FAST64_MAX : (start + budget)};
+
+      m_seq.store(m_seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      // as a seqlock writer: the new seq is visible before any field of the
+      // new run, so the watchdog's re-check of seq catches a mixed read
+      std::atomic_thread_fence(std::memory_order_release);
+      m_start.store(start, std::memory_order_relaxed);
+      m_startLabel.store(startLabel, std::memory_order_relaxed);
+      m_threadId.store(threadId, std::memory_order_relaxed);
+      m_startCpu.store(startCpu, std::memory_order_relaxed);
+      m_deadline.store(deadline, std::memory_order_release);
+    }
+
+    void
+    end() noexcept
+    {
+      m_deadline.store(0, std::memory_order_release);
+    }
+
+   private:
+    friend class deadlineWatchdog;
+
+    labelId m_timerId {};
+    // 0: not running
+    std::atomic<uint_fast64_t> m_deadline {0};
+    std::atomic<uint_fast64_t> m_seq {0};
+    std::atomic<uint_fast64_t> m_start {0};
+    std::atomic<labelId> m_startLabel {0};
+    std::atomic<uint32_t> m_threadId {0};
+    std::atomic<uint32_t> m_startCpu {unknownCpu};
+    // the last run flagged, touched by the watchdog only
+    uint_fast64_t m_flaggedSeq {0};
+  };  // class slot
+
+  using stallCallback = std::function<void(const stalledRegion&)>;
+
+  explicit deadlineWatchdog(stallCallback onStall,
+                            const std::chrono::milliseconds& period = std::chrono::milliseconds(1));
+
+  ~deadlineWatchdog() noexcept;
+
+  deadlineWatchdog(const deadlineWatchdog&) = delete;
+  deadlineWatchdog& operator=(const deadlineWatchdog&) = delete;
+
+  // a free slot for the timer with the given id; used by rdtscTimer::watchWith()
+  slot* acquire(const labelId timerId);
+
+  // give the slot back: its run, if any, is no longer watched
+  void release(slot* s) noexcept;
+
+  // check every slot now, on the calling thread; returns the stalls found
+  std::size_t scan();
+
+  std::size_t getWatchedCount() const;
+
+  uint_fast64_t
+  getScansCount() const noexcept
+  {
+    return m_scans.load(std::memory_order_relaxed);
+  }
+
+  uint_fast64_t
+  getStallsCount() const noexcept
+  {
+    return m_stalls.load(std::memory_order_relaxed);
+  }
+
+ private:
+  const stallCallback m_onStall;
+  const std::chrono::milliseconds m_period;
+  // taken by acquire(), release() and scan(): the hot path never takes it
+  mutable std::mutex m_slotsMutex {};
+  std::vector<std::unique_ptr<slot>> m_slots {};
+  std::vector<slot*> m_freeSlots {};
+  std::atomic<uint_fast64_t> m_scans {0};
+  std::atomic<uint_fast64_t> m_stalls {0};
+  std::mutex m_mutex {};
+  std::condition_variable m_wakeUp {};
+  bool m_stopRequested {false};
+  std::thread m_watchdog {};
+
+  void watchdogLoop();
+};  // class deadlineWatchdog
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
@@ -0,0 +1,134 @@
+/*
+ * File:   latency_histogram.cpp
+ * Author: massimo
+ *
+ * Created on October 16, 2026, 11:40 AM
+ */
+#include "latency_histogram.h"
+#include "tsc_clock.h"
+#include <algorithm>
+#include <cmath>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+tickHistogram::tickHistogram()
+:
+m_buckets(bucketCount, 0)
+{}
+
+void
+tickHistogram::record(const uint_fast64_t ticks, const uint_fast64_t count) noexcept
+{
+  m_buckets[bucketIndex(ticks)] += count;
+  m_count += count;
+  m_sum += ticks * count;
+  m_min = std::min(m_min, ticks);
+  m_max = std::max(m_max, ticks);
+}
+
+void
+tickHistogram::merge(const tickHistogram& other) noexcept
+{
+  for (uint_fast32_t&& i {0}; i < bucketCount; ++i)
+  {
+    m_buckets[i] += other.m_buckets[i];
+  }
+  m_count += other.m_count;
+  m_sum += other.m_sum;
+  m_min = std::min(m_min, other.m_min);
+  m_max = std::max(m_max, other.m_max);
+}
+
+uint_fast64_t
+tickHistogram::percentile(const double q) const noexcept
+{
+  if ( 0 == m_count )
+  {
+    return 0;
+  }
+
+  // rank of the requested sample, 1-based
+  const double clamped {std::min(std::max(q, 0.0), 1.0)};
+  const uint_fast64_t rank {std::max(uint_fast64_t{1},
+                                     static_cast<uint_fast64_t>(std::ceil(clamped * static_cast<double>(m_count))))};
+  uint_fast64_t seen {0};
+
+  for (uint_fast32_t&& i {0}; i < bucketCount; ++i)
+  {
+    seen += m_buckets[i];
+    if ( seen >= rank )
+    {
+      return std::min(std::max(bucketUpperBound(i), getMin()), m_max);
+    }
+  }
+  return m_max;
+}
+
+double
+tickHistogram::mean() const noexcept
+{
+  if ( 0 == m_count )
+  {
+    return 0.0;
+  }
+  return static_cast<double>(m_sum) / static_cast<double>(m_count);
+}
+
+std::ostream& operator<<(std::ostream& os, const tickHistogram& obj)
+{
+  const std::vector<std::pair<const char*, uint_fast64_t>> values {
+    {"min",   obj.getMin()},
+    {"p50",   obj.percentile(0.50)},
+    {"p90",   obj.percentile(0.90)},
+    {"p99",   obj.percentile(0.99)},
+    {"p99.9", obj.percentile(0.999)},
+    {"max",   obj.getMax()}
+  };
+
+  os << obj.getCount() << " samples:";
+  for (auto&& v : values)
+  {
+    os << ' ' << v.first << ' ' << v.second;
+  }
+  os << " ticks [";
+  for (auto&& v : values)
+  {
+    os << ' ' << v.first << ' ' << tsc_clock::toNanoseconds(v.second);
+  }
+  os << " nsec ]";
+
+  return os;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+latencyHistogram::latencyHistogram(const std::string& name)
+:
+m_name{name}
+{}
+
+tickHistogram
+latencyHistogram::snapshot() const
+{
+  tickHistogram&& h {};
+
+  m_shards.forEach([&h] (const shard& s)
+  {
+    for (uint_fast32_t&& i {0}; i < tickHistogram::bucketCount; ++i)
+    {
+      h.m_buckets[i] += s.buckets[i].load(std::memory_order_relaxed);
+    }
+    h.m_count += s.count.load(std::memory_order_relaxed);
+    h.m_sum += s.sum.load(std::memory_order_relaxed);
+    h.m_min = std::min(h.m_min, s.min.load(std::memory_order_relaxed));
+    h.m_max = std::max(h.m_max, s.max.load(std::memory_order_relaxed));
+  });
+
+  return h;
+}
+
+void
+latencyHistogram::report(std::ostream& os) const
+{
+  os << m_name << ": " << snapshot() << '\n';
+}
+}  // namespace timeSupport
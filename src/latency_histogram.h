@@ -0,0 +1,196 @@
+/*
+ * File:   latency_histogram.h
+ * Author: massimo
+ *
+ * Created on October 16, 2026, 11:40 AM
+ */
+#pragma once
+
+#include "thread_shards.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+// log-linear (HDR-style) histogram of tick counts
+// values below 2 * subBucketCount get one bucket each; above that, every
+// power of two range is split in subBucketCount linear buckets, so the
+// relative error of a bucket is below 1 / subBucketCount
+class tickHistogram final
+{
+ public:
+  static constexpr uint_fast32_t subBucketBits {5};
+  static constexpr uint_fast32_t subBucketCount {uint_fast32_t{1} << subBucketBits};
+  static constexpr uint_fast32_t bucketCount {(64 - subBucketBits + 1) * subBucketCount};
+
+  static
+  constexpr
+  uint_fast32_t
+  bucketIndex(const uint_fast64_t ticks) noexcept
+  {
+    if ( ticks < subBucketCount )
+    {
+      return static_cast<uint_fast32_t>(ticks);
+    }
+
+    const uint_fast32_t msb {static_cast<uint_fast32_t>(63 - __builtin_clzll(ticks))};
+    const uint_fast32_t shift {msb - subBucketBits};
+
+    return static_cast<uint_fast32_t>(((shift + 1) * subBucketCount) + ((ticks >> shift) - subBucketCount));
+  }
+
+  static
+  constexpr
+  uint_fast64_t
+  bucketLowerBound(const uint_fast32_t index) noexcept
+  {
+    if ( index < subBucketCount )
+    {
+      return index;
+    }
+
+    const uint_fast32_t shift {(index / subBucketCount) - 1};
+
+    return (subBucketCount + (index % subBucketCount)) << shift;
+  }
+
+  static
+  constexpr
+  uint_fast64_t
+  bucketUpperBound(const uint_fast32_t index) noexcept
+  {
+    if ( index < subBucketCount )
+    {
+      return index;
+    }
+
+    const uint_fast32_t shift {(index / subBucketCount) - 1};
+
+    return bucketLowerBound(index) + ((uint_fast64_t{1} << shift) - 1);
+  }
+
+  tickHistogram();
+
+  void record(const uint_fast64_t ticks, const uint_fast64_t count = 1) noexcept;
+
+  void merge(const tickHistogram& other) noexcept;
+
+  // the value at quantile q (0.0 - 1.0), as the upper bound of its bucket
+  uint_fast64_t percentile(const double q) const noexcept;
+
+  double mean() const noexcept;
+
+  uint_fast64_t
+  getCount() const noexcept
+  {
+    return m_count;
+  }
+
+  uint_fast64_t
+  getSum() const noexcept
+  {
+    return m_sum;
+  }
+
+  uint_fast64_t
+  getMin() const noexcept
+  {
+    return (0 == m_count) ? 0 : m_min;
+  }
+
+  uint_fast64_t
+  getMax() const noexcept
+  {
+    return m_max;
+  }
+
+  uint_fast64_t
+  getBucket(const uint_fast32_t index) const noexcept
+  {
+    return m_buckets[index];
+  }
+
+  // writes count, min, p50, p90, p99, p99.9, max in ticks and nsec
+  friend std::ostream& operator<<(std::ostream& os, const tickHistogram& obj);
+
+ private:
+  std::vector<uint_fast64_t> m_buckets {};
+  uint_fast64_t m_count {};
+  uint_fast64_t m_sum {};
+  uint_fast64_t m_min {UINT_FAST64_MAX};
+  uint_fast64_t m_max {};
+
+  friend class latencyHistogram;
+};  // class tickHistogram
+
+////////////////////////////////////////////////////////////////////////////////
+// a tick histogram recorded concurrently by many threads
+// every thread records into its own cache-line-aligned shard with relaxed
+// loads and stores only: record() never locks, never allocates (after the
+// first sample of a thread) and never contends with other threads
+// shards are merged only when snapshot() or report() is called
+class latencyHistogram final
+{
+ public:
+  struct alignas(64) shard
+  {
+    std::array<std::atomic<uint_fast64_t>, tickHistogram::bucketCount> buckets {};
+    std::atomic<uint_fast64_t> count {};
+    std::atomic<uint_fast64_t> sum {};
+    std::atomic<uint_fast64_t> min {UINT_FAST64_MAX};
+    std::atomic<uint_fast64_t> max {};
+
+    // single writer: the owning thread
+    void
+    record(const uint_fast64_t ticks, const uint_fast64_t n = 1) noexcept
+    {
+      auto&& b = buckets[tickHistogram::bucketIndex(ticks)];
+
+      b.store(b.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+      count.store(count.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+      sum.store(sum.load(std::memory_order_relaxed) + (ticks * n), std::memory_order_relaxed);
+      if ( ticks < min.load(std::memory_order_relaxed) )
+      {
+        min.store(ticks, std::memory_order_relaxed);
+      }
+      if ( ticks > max.load(std::memory_order_relaxed) )
+      {
+        max.store(ticks, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  explicit latencyHistogram(const std::string& name = "latencyHistogram");
+
+  latencyHistogram(const latencyHistogram&) = delete;
+  latencyHistogram& operator=(const latencyHistogram&) = delete;
+
+  // n: the executions the sample stands for, when sampled
+  void
+  record(const uint_fast64_t ticks, const uint_fast64_t n = 1) noexcept
+  {
+    m_shards.local().record(ticks, n);
+  }
+
+  // merge all the threads' shards
+  tickHistogram snapshot() const;
+
+  // write the merged percentiles
+  void report(std::ostream& os = std::cout) const;
+
+  const std::string&
+  getName() const noexcept
+  {
+    return m_name;
+  }
+
+ private:
+  const std::string m_name {};
+  threadShards<shard> m_shards {};
+};  // class latencyHistogram
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
@@ -0,0 +1,274 @@
+/*
+ * File:   perf_counters.cpp
+ * Author: massimo
+ *
+ * Created on October 20, 2026, 10:15 AM
+ */
+#include "perf_counters.h"
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+namespace
+{
+struct counterConfig
+{
+  uint32_t type;
+  uint64_t config;
+  // user space only: allowed with perf_event_paranoid up to 2
+  bool userOnly;
+};
+
+// context switches happen in the kernel: excluding it would count none
+constexpr std::array<counterConfig, perfCountersCount> configs {{
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES,       true},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS,     true},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES,     true},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES,    true},
+  {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, false}
+}};
+
+int
+perfEventOpen(perf_event_attr& attr, const int groupFd) noexcept
+{
+  // this thread, any cpu
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+
+inline
+uint64_t
+rdpmc(const uint32_t counter) noexcept
+{
+  uint32_t lo {};
+  uint32_t hi {};
+
+  __asm__ __volatile__("rdpmc" : "=a" (lo), "=d" (hi) : "c" (counter));
+
+  return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+
+double
+perKilo(const uint64_t n, const uint64_t instructions) noexcept
+{
+  return (0 == instructions) ? 0.0 : (1000.0 * static_cast<double>(n)) / static_cast<double>(instructions);
+}
+}  // namespace
+
+const char*
+perfCounterName(const perfCounter c) noexcept
+{
+  constexpr std::array<const char*, perfCountersCount> names {{
+    "cycles", "instructions", "LLC-misses", "branch-misses", "context-switches"
+  }};
+
+  return names[static_cast<std::size_t>(c)];
+}
+
+double
+perfCounterValues::ipc() const noexcept
+{
+  if ( (!has(perfCounter::CYCLES)) || (!has(perfCounter::INSTRUCTIONS)) || (0 == get(perfCounter::CYCLES)) )
+  {
+    return 0.0;
+  }
+  return static_cast<double>(get(perfCounter::INSTRUCTIONS)) / static_cast<double>(get(perfCounter::CYCLES));
+}
+
+double
+perfCounterValues::llcMissesPerKiloInstructions() const noexcept
+{
+  if ( (!has(perfCounter::LLC_MISSES)) || (!has(perfCounter::INSTRUCTIONS)) )
+  {
+    return 0.0;
+  }
+  return perKilo(get(perfCounter::LLC_MISSES), get(perfCounter::INSTRUCTIONS));
+}
+
+double
+perfCounterValues::branchMissesPerKiloInstructions() const noexcept
+{
+  if ( (!has(perfCounter::BRANCH_MISSES)) || (!has(perfCounter::INSTRUCTIONS)) )
+  {
+    return 0.0;
+  }
+  return perKilo(get(perfCounter::BRANCH_MISSES), get(perfCounter::INSTRUCTIONS));
+}
+
+std::ostream& operator<<(std::ostream& os, const perfCounterValues& obj)
+{
+  bool first {true};
+
+  for (std::size_t&& i {0}; i < perfCountersCount; ++i)
+  {
+    const perfCounter c {static_cast<perfCounter>(i)};
+
+    if ( obj.has(c) )
+    {
+      os << (first ? "" : ", ") << perfCounterName(c) << ' ' << obj.get(c);
+      first = false;
+    }
+  }
+  if ( obj.has(perfCounter::CYCLES) && obj.has(perfCounter::INSTRUCTIONS) )
+  {
+    const auto flags {os.flags()};
+    const auto precision {os.precision()};
+
+    os << std::fixed << std::setprecision(3)
+       << ", IPC " << obj.ipc();
+    if ( obj.has(perfCounter::LLC_MISSES) )
+    {
+      os << ", LLC-MPKI " << obj.llcMissesPerKiloInstructions();
+    }
+    if ( obj.has(perfCounter::BRANCH_MISSES) )
+    {
+      os << ", branch-MPKI " << obj.branchMissesPerKiloInstructions();
+    }
+    os.flags(flags);
+    os.precision(precision);
+  }
+
+  return os;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+perfCounterGroup::perfCounterGroup() noexcept
+{
+  const long pageSize {sysconf(_SC_PAGESIZE)};
+  int leader {-1};
+
+  m_fds.fill(-1);
+  m_pages.fill(nullptr);
+  for (std::size_t&& i {0}; i < perfCountersCount; ++i)
+  {
+    perf_event_attr attr {};
+
+    attr.size = sizeof(attr);
+    attr.type = configs[i].type;
+    attr.config = configs[i].config;
+    attr.exclude_kernel = configs[i].userOnly ? 1 : 0;
+    attr.exclude_hv = 1;
+
+    // the group is scheduled on the PMU as a whole
+    const int fd {perfEventOpen(attr, leader)};
+
+    if ( fd < 0 )
+    {
+      if ( m_error.empty() )
+      {
+        m_error = std::string{perfCounterName(static_cast<perfCounter>(i))} + ": " + std::strerror(errno);
+      }
+      continue;
+    }
+    if ( leader < 0 )
+    {
+      leader = fd;
+    }
+    m_fds[i] = fd;
+    m_available |= 1u << i;
+
+    // the user page of a hardware counter gives its rdpmc index
+    if ( PERF_TYPE_HARDWARE == configs[i].type )
+    {
+      void* page {mmap(nullptr, static_cast<std::size_t>(pageSize), PROT_READ, MAP_SHARED, fd, 0)};
+
+      if ( MAP_FAILED != page )
+      {
+        m_pages[i] = static_cast<perf_event_mmap_page*>(page);
+      }
+    }
+  }
+}
+
+perfCounterGroup::~perfCounterGroup() noexcept
+{
+  const long pageSize {sysconf(_SC_PAGESIZE)};
+
+  // the leader is closed last
+  for (std::size_t i {perfCountersCount}; i > 0; --i)
+  {
+    if ( nullptr != m_pages[i - 1] )
+    {
+      munmap(m_pages[i - 1], static_cast<std::size_t>(pageSize));
+    }
+    if ( m_fds[i - 1] >= 0 )
+    {
+      close(m_fds[i - 1]);
+    }
+  }
+}
+
+bool
+perfCounterGroup::usesRdpmc(const perfCounter c) const noexcept
+{
+  const perf_event_mmap_page* pc {m_pages[static_cast<std::size_t>(c)]};
+
+  return (nullptr != pc) && (0 != pc->cap_user_rdpmc);
+}
+
+uint64_t
+perfCounterGroup::readCounter(const std::size_t i) const noexcept
+{
+  const volatile perf_event_mmap_page* pc {m_pages[i]};
+
+  if ( nullptr != pc )
+  {
+    uint32_t seq {};
+    uint32_t index {};
+    uint64_t count {};
+
+    // the kernel updates the page under a sequence lock
+    do
+    {
+      seq = pc->lock;
+      __asm__ __volatile__("" : : : "memory");
+      index = pc->index;
+      count = static_cast<uint64_t>(pc->offset);
+      if ( (0 != pc->cap_user_rdpmc) && (0 != index) )
+      {
+        // sign extend the pmc_width bits of the counter
+        const uint16_t shift {static_cast<uint16_t>(64 - pc->pmc_width)};
+        const int64_t pmc {static_cast<int64_t>(rdpmc(index - 1) << shift) >> shift};
+
+        count += static_cast<uint64_t>(pmc);
+      }
+      __asm__ __volatile__("" : : : "memory");
+    } while ( pc->lock != seq );
+
+    if ( (0 != pc->cap_user_rdpmc) && (0 != index) )
+    {
+      return count;
+    }
+  }
+
+  // not on the PMU right now, or rdpmc not allowed
+  uint64_t count {0};
+
+  if ( static_cast<ssize_t>(sizeof(count)) != ::read(m_fds[i], &count, sizeof(count)) )
+  {
+    return 0;
+  }
+  return count;
+}
+
+perfCounterValues
+perfCounterGroup::read() const noexcept
+{
+  perfCounterValues v {};
+
+  v.available = m_available;
+  for (std::size_t&& i {0}; i < perfCountersCount; ++i)
+  {
+    if ( m_fds[i] >= 0 )
+    {
+      v.values[i] = readCounter(i);
+    }
+  }
+  return v;
+}
+}  // namespace timeSupport
@@ -0,0 +1,130 @@
+/*
+ * File:   perf_counters.h
+ * Author: massimo
+ *
+ * Created on October 20, 2026, 10:15 AM
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+////////////////////////////////////////////////////////////////////////////////
+struct perf_event_mmap_page;
+
+namespace timeSupport
+{
+enum class perfCounter : std::size_t
+{
+  CYCLES,
+  INSTRUCTIONS,
+  LLC_MISSES,
+  BRANCH_MISSES,
+  CONTEXT_SWITCHES
+};
+
+constexpr std::size_t perfCountersCount {5};
+
+// the values of the counters of a perfCounterGroup: read at a point, or the
+// difference of two reads; a counter that could not be opened is not
+// available and reads 0
+struct perfCounterValues
+{
+  std::array<uint64_t, perfCountersCount> values {};
+  uint32_t available {0};
+
+  constexpr
+  bool
+  has(const perfCounter c) const noexcept
+  {
+    return 0 != (available & (1u << static_cast<std::size_t>(c)));
+  }
+
+  constexpr
+  uint64_t
+  get(const perfCounter c) const noexcept
+  {
+    return values[static_cast<std::size_t>(c)];
+  }
+
+  // instructions per cycle, 0 when not available
+  double ipc() const noexcept;
+
+  // misses per thousand instructions, 0 when not available
+  double llcMissesPerKiloInstructions() const noexcept;
+  double branchMissesPerKiloInstructions() const noexcept;
+
+  // the counts from start to this
+  perfCounterValues
+  operator-(const perfCounterValues& start) const noexcept
+  {
+    perfCounterValues delta {};
+
+    delta.available = available & start.available;
+    for (std::size_t&& i {0}; i < perfCountersCount; ++i)
+    {
+      delta.values[i] = values[i] - start.values[i];
+    }
+    return delta;
+  }
+
+  // the counts and ratios available, nothing when no counter is
+  friend std::ostream& operator<<(std::ostream& os, const perfCounterValues& obj);
+};
+
+const char* perfCounterName(const perfCounter c) noexcept;
+
+////////////////////////////////////////////////////////////////////////////////
+// a group of Linux perf_event_open counters of the calling thread: cycles,
+// instructions, LLC misses and branch misses in user space, and context
+// switches; the hardware counters are read with rdpmc when the kernel allows
+// it, with read() otherwise
+// each counter is opened on its own: the ones not permitted (see
+// /proc/sys/kernel/perf_event_paranoid) or not supported (e.g. in a VM without
+// a virtual PMU) are just not available, getError() says why
+// the group counts the thread that creates it: read it on that thread only
+class perfCounterGroup final
+{
+ public:
+  perfCounterGroup() noexcept;
+  ~perfCounterGroup() noexcept;
+
+  perfCounterGroup(const perfCounterGroup&) = delete;
+  perfCounterGroup& operator=(const perfCounterGroup&) = delete;
+
+  perfCounterValues read() const noexcept;
+
+  // true when at least one counter is available
+  bool
+  isAvailable() const noexcept
+  {
+    return 0 != m_available;
+  }
+
+  bool
+  isAvailable(const perfCounter c) const noexcept
+  {
+    return 0 != (m_available & (1u << static_cast<std::size_t>(c)));
+  }
+
+  // true when counter c is read with rdpmc
+  bool usesRdpmc(const perfCounter c) const noexcept;
+
+  // the first failure to open a counter, empty when all are available
+  const std::string&
+  getError() const noexcept
+  {
+    return m_error;
+  }
+
+ private:
+  std::array<int, perfCountersCount> m_fds {};
+  std::array<perf_event_mmap_page*, perfCountersCount> m_pages {};
+  uint32_t m_available {0};
+  std::string m_error {};
+
+  uint64_t readCounter(const std::size_t i) const noexcept;
+};  // class perfCounterGroup
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
@@ -0,0 +1,328 @@
+/*
+ * File:   prometheus_exporter.cpp
+ * Author: massimo
+ *
+ * Created on October 21, 2026, 9:20 AM
+ */
+#include "prometheus_exporter.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <utility>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+namespace
+{
+// a label value: backslash, double quote and new line are escaped
+std::string
+escapeLabel(const std::string& value)
+{
+  std::string escaped {};
+
+  escaped.reserve(value.size());
+  for (auto&& c : value)
+  {
+    switch ( c )
+    {
+      case '\\': escaped += "\\\\"; break;
+      case '"':  escaped += "\\\""; break;
+      case '\n': escaped += "\\n";  break;
+      default:   escaped += c;      break;
+    }
+  }
+  return escaped;
+}
+
+bool
+writeAll(const int fd, const std::string& data) noexcept
+{
+  std::size_t written {0};
+
+  while ( written < data.size() )
+  {
+    const ssize_t n {::send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL)};
+
+    if ( n <= 0 )
+    {
+      return false;
+    }
+    written += static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+// the le bounds of the buckets, the same for every timer and every scrape:
+// 1-2-5 steps from 100 nsec to 100 sec, in seconds and in ticks
+std::vector<std::pair<std::string, uint_fast64_t>>
+bucketLadder(const double tscHz)
+{
+  std::vector<std::pair<std::string, uint_fast64_t>> ladder {};
+
+  for (int&& e {-7}; e <= 2; ++e)
+  {
+    for (auto&& m : {1.0, 2.0, 5.0})
+    {
+      const double seconds {m * std::pow(10.0, e)};
+      std::ostringstream le {};
+
+      if ( seconds > 100.0 )
+      {
+        break;
+      }
+      le << seconds;
+      ladder.emplace_back(le.str(), static_cast<uint_fast64_t>(seconds * tscHz));
+    }
+  }
+  return ladder;
+}
+}  // namespace
+
+void
+writePrometheus(const timerRegistry& registry, std::ostream& os)
+{
+  const double tscHz {static_cast<double>(tsc_clock::calibration().tscHz)};
+  const auto flags {os.flags()};
+  const auto precision {os.precision()};
+
+  // the sums in full precision
+  os << std::setprecision(std::numeric_limits<double>::max_digits10);
+  os << "# HELP timesupport_tsc_hz The calibrated TSC frequency.\n"
+     << "# TYPE timesupport_tsc_hz gauge\n"
+     << "timesupport_tsc_hz " << tscHz << '\n'
+     << "# HELP timesupport_clock_backend The clock the timers read.\n"
+     << "# TYPE timesupport_clock_backend gauge\n"
+     << "timesupport_clock_backend{backend=\"" << clockBackendName(activeClockBackend()) << "\"} 1\n"
+     << "# HELP timesupport_timer_seconds The regions timed by the registered timers.\n"
+     << "# TYPE timesupport_timer_seconds histogram\n";
+  const std::vector<std::pair<std::string, uint_fast64_t>>&& ladder = bucketLadder(tscHz);
+
+  registry.forEach([&os, &ladder, tscHz] (const sharedTimer& t)
+  {
+    const tickHistogram&& h = t.snapshot();
+    const std::string&& label = "{timer=\"" + escapeLabel(t.getName()) + "\"";
+    uint_fast64_t cumulative {0};
+    uint_fast32_t i {0};
+
+    // an HDR bucket counts under the first le that holds all of it
+    for (auto&& bound : ladder)
+    {
+      for (; (i < tickHistogram::bucketCount) && (tickHistogram::bucketUpperBound(i) <= bound.second); ++i)
+      {
+        cumulative += h.getBucket(i);
+      }
+      os << "timesupport_timer_seconds_bucket" << label
+         << ",le=\"" << bound.first << "\"} " << cumulative << '\n';
+    }
+    for (; i < tickHistogram::bucketCount; ++i)
+    {
+      cumulative += h.getBucket(i);
+    }
+    os << "timesupport_timer_seconds_bucket" << label << ",le=\"+Inf\"} " << cumulative << '\n'
+       << "timesupport_timer_seconds_sum" << label << "} " << static_cast<double>(h.getSum()) / tscHz << '\n'
+       << "timesupport_timer_seconds_count" << label << "} " << cumulative << '\n';
+  });
+  os.flags(flags);
+  os.precision(precision);
+}
+
+bool
+writePrometheusFile(const timerRegistry& registry, const std::string& fileName)
+{
+  const std::string&& tmpFileName = fileName + ".tmp";
+
+  {
+    std::ofstream f {tmpFileName, std::ios::trunc};
+
+    if ( !f )
+    {
+      return false;
+    }
+    writePrometheus(registry, f);
+    f.flush();
+    if ( !f )
+    {
+      std::remove(tmpFileName.c_str());
+      return false;
+    }
+  }
+  return 0 == std::rename(tmpFileName.c_str(), fileName.c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+prometheusExporter::prometheusExporter(const timerRegistry& registry,
+                                       const std::string& fileName,
+                                       const std::chrono::milliseconds& period)
+:
+m_registry(registry),
+m_fileName{fileName},
+m_period{period}
+{
+  m_exporter = std::thread(&prometheusExporter::exporterLoop, this);
+}
+
+prometheusExporter::~prometheusExporter() noexcept
+{
+  {
+    std::lock_guard<std::mutex> lock {m_mutex};
+
+    m_stopRequested = true;
+  }
+  m_wakeUp.notify_one();
+  if ( m_exporter.joinable() )
+  {
+    m_exporter.join();
+  }
+}
+
+void
+prometheusExporter::exportOnce()
+{
+  if ( writePrometheusFile(m_registry, m_fileName) )
+  {
+    m_exports.fetch_add(1, std::memory_order_relaxed);
+  }
+  else
+  {
+    m_failed.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void
+prometheusExporter::exporterLoop()
+{
+  std::unique_lock<std::mutex> lock {m_mutex};
+
+  for (;;)
+  {
+    const bool stopping {m_wakeUp.wait_for(lock, m_period, [this] () { return m_stopRequested; })};
+
+    lock.unlock();
+    exportOnce();
+    lock.lock();
+    if ( stopping )
+    {
+      return;
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+prometheusEndpoint::prometheusEndpoint(const timerRegistry& registry, const std::string& socketPath)
+:
+m_registry(registry),
+m_socketPath{socketPath}
+{
+  sockaddr_un address {};
+
+  if ( m_socketPath.size() >= sizeof(address.sun_path) )
+  {
+    return;
+  }
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, m_socketPath.c_str(), m_socketPath.size() + 1);
+
+  m_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if ( m_fd < 0 )
+  {
+    return;
+  }
+  ::unlink(m_socketPath.c_str());
+  if ( (0 != ::bind(m_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address))) ||
+       (0 != ::listen(m_fd, 16)) )
+  {
+    ::close(m_fd);
+    m_fd = -1;
+    return;
+  }
+  m_server = std::thread(&prometheusEndpoint::serverLoop, this);
+}
+
+prometheusEndpoint::~prometheusEndpoint() noexcept
+{
+  m_stopRequested.store(true, std::memory_order_relaxed);
+  if ( m_server.joinable() )
+  {
+    m_server.join();
+  }
+  if ( m_fd >= 0 )
+  {
+    ::close(m_fd);
+    ::unlink(m_socketPath.c_str());
+  }
+}
+
+void
+prometheusEndpoint::serverLoop()
+{
+  pollfd p {m_fd, POLLIN, 0};
+
+  // poll with a timeout: the dtor only has to set the flag
+  while ( !m_stopRequested.load(std::memory_order_relaxed) )
+  {
+    if ( (::poll(&p, 1, 100) <= 0) || (0 == (p.revents & POLLIN)) )
+    {
+      continue;
+    }
+
+    const int fd {::accept4(m_fd, nullptr, nullptr, SOCK_CLOEXEC)};
+
+    if ( fd < 0 )
+    {
+      continue;
+    }
+    serve(fd);
+    ::close(fd);
+  }
+}
+
+void
+prometheusEndpoint::serve(const int fd)
+{
+  // read the request up to the end of its headers, whatever it is
+  std::string request {};
+  char buffer[1024];
+  pollfd p {fd, POLLIN, 0};
+
+  while ( (std::string::npos == request.find("\r\n\r\n")) &&
+          (std::string::npos == request.find("\n\n")) &&
+          (request.size() < 8192) &&
+          (::poll(&p, 1, 1000) > 0) )
+  {
+    const ssize_t n {::recv(fd, buffer, sizeof(buffer), 0)};
+
+    if ( n <= 0 )
+    {
+      break;
+    }
+    request.append(buffer, static_cast<std::size_t>(n));
+  }
+
+  std::ostringstream body {};
+
+  writePrometheus(m_registry, body);
+
+  const std::string& text = body.str();
+  std::ostringstream response {};
+
+  response << "HTTP/1.0 200 OK\r\n"
+           << "Content-Type: text/plain; version=0.0.4\r\n"
+           << "Content-Length: " << text.size() << "\r\n"
+           << "Connection: close\r\n"
+           << "\r\n"
+           << text;
+  if ( writeAll(fd, response.str()) )
+  {
+    m_scrapes.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+}  // namespace timeSupport
@@ -0,0 +1,125 @@
+/*
+ * File:   prometheus_exporter.h
+ * Author: massimo
+ *
+ * Created on October 21, 2026, 9:20 AM
+ */
+#pragma once
+
+#include "timer_registry.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+// write the timers of registry in the Prometheus text exposition format:
+// the histogram timesupport_timer_seconds{timer="name"}, _sum and _count,
+// and the gauges timesupport_tsc_hz and timesupport_clock_backend{backend="name"}
+// every timer gets the same le ladder on every scrape, 1-2-5 steps from
+// 100 nsec to 100 sec, and +Inf; each le counts the HDR buckets of the timer
+// it holds entirely, and _count always equals the +Inf bucket
+// the timers are read live: the recording threads are never stopped, so
+// _sum may include a sample recorded meanwhile that the buckets miss, or
+// the other way round
+void writePrometheus(const timerRegistry& registry, std::ostream& os);
+
+// write to fileName.tmp and rename it to fileName, so a reader never sees a
+// partial file; false on error
+bool writePrometheusFile(const timerRegistry& registry, const std::string& fileName);
+
+////////////////////////////////////////////////////////////////////////////////
+// writes the Prometheus file every period from a background thread, and once
+// more when destroyed; the registry must outlive the exporter
+class prometheusExporter final
+{
+ public:
+  prometheusExporter(const timerRegistry& registry,
+                     const std::string& fileName,
+                     const std::chrono::milliseconds& period = std::chrono::seconds(10));
+
+  ~prometheusExporter() noexcept;
+
+  prometheusExporter(const prometheusExporter&) = delete;
+  prometheusExporter& operator=(const prometheusExporter&) = delete;
+
+  uint_fast64_t
+  getExportsCount() const noexcept
+  {
+    return m_exports.load(std::memory_order_relaxed);
+  }
+
+  uint_fast64_t
+  getFailedExports() const noexcept
+  {
+    return m_failed.load(std::memory_order_relaxed);
+  }
+
+ private:
+  const timerRegistry& m_registry;
+  const std::string m_fileName;
+  const std::chrono::milliseconds m_period;
+  std::atomic<uint_fast64_t> m_exports {0};
+  std::atomic<uint_fast64_t> m_failed {0};
+  std::mutex m_mutex {};
+  std::condition_variable m_wakeUp {};
+  bool m_stopRequested {false};
+  std::thread m_exporter {};
+
+  void exporterLoop();
+  void exportOnce();
+};  // class prometheusExporter
+
+////////////////////////////////////////////////////////////////////////////////
+// serves the Prometheus text of registry over HTTP on a local Unix socket:
+//   curl --unix-socket /run/app/metrics.sock http://localhost/metrics
+// any request gets the metrics; a background thread serves one connection at
+// a time; an existing socket file is replaced, and removed when destroyed
+// the registry must outlive the endpoint
+class prometheusEndpoint final
+{
+ public:
+  prometheusEndpoint(const timerRegistry& registry, const std::string& socketPath);
+
+  ~prometheusEndpoint() noexcept;
+
+  prometheusEndpoint(const prometheusEndpoint&) = delete;
+  prometheusEndpoint& operator=(const prometheusEndpoint&) = delete;
+
+  // false when the socket could not be bound
+  bool
+  isOpen() const noexcept
+  {
+    return m_fd >= 0;
+  }
+
+  const std::string&
+  getSocketPath() const noexcept
+  {
+    return m_socketPath;
+  }
+
+  uint_fast64_t
+  getScrapesCount() const noexcept
+  {
+    return m_scrapes.load(std::memory_order_relaxed);
+  }
+
+ private:
+  const timerRegistry& m_registry;
+  const std::string m_socketPath;
+  int m_fd {-1};
+  std::atomic<bool> m_stopRequested {false};
+  std::atomic<uint_fast64_t> m_scrapes {0};
+  std::thread m_server {};
+
+  void serverLoop();
+  void serve(const int fd);
+};  // class prometheusEndpoint
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
@@ -0,0 +1,142 @@
+/*
+ * File:   rate_meter.cpp
+ * Author: massimo
+ *
+ * Created on October 24, 2026, 10:15 AM
+ */
+#include "rate_meter.h"
+#include <algorithm>
+#include <cmath>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+namespace
+{
+constexpr std::array<uint_fast64_t, rateWindowsCount> windowSeconds {1, 10, 60};
+
+constexpr double tickSeconds {static_cast<double>(rateMeter::tickInterval.count()) / 1e3};
+
+constexpr uint_fast64_t ticksPerSecond {1'000 / static_cast<uint_fast64_t>(rateMeter::tickInterval.count())};
+}  // namespace
+
+const char*
+rateWindowName(const rateWindow w) noexcept
+{
+  switch ( w )
+  {
+    case rateWindow::ONE_SECOND:  return "1s";
+    case rateWindow::TEN_SECONDS: return "10s";
+    case rateWindow::ONE_MINUTE:  return "1m";
+  }
+  return "?";
+}
+
+std::ostream& operator<<(std::ostream& os, const rateSnapshot& obj)
+{
+  os << "count " << obj.count
+     << ", mean " << obj.meanRate << "/s";
+  for (std::size_t&& i {0}; i < rateWindowsCount; ++i)
+  {
+    os << ", " << rateWindowName(static_cast<rateWindow>(i)) << ' ' << obj.windowRates[i] << "/s";
+  }
+  os << ", EWMA";
+  for (std::size_t&& i {0}; i < rateWindowsCount; ++i)
+  {
+    os << ((0 == i) ? " " : ", ") << rateWindowName(static_cast<rateWindow>(i)) << ' ' << obj.ewmaRates[i] << "/s";
+  }
+  return os;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+rateMeter::rateMeter(const std::string& name)
+:
+m_name{name},
+m_tickTicks{std::max<uint_fast64_t>(tsc_clock::toTicks(tickInterval), 1)},
+m_start{stopTSC()}
+{}
+
+uint_fast64_t
+rateMeter::getCount() const
+{
+  uint_fast64_t count {0};
+
+  m_shards.forEach([&count] (const shard& s)
+  {
+    count += s.count.load(std::memory_order_relaxed);
+  });
+  return count;
+}
+
+void
+rateMeter::tickTo(const uint_fast64_t tsc, const uint_fast64_t count) const
+{
+  const uint_fast64_t ticks {(tsc > m_start) ? ((tsc - m_start) / m_tickTicks) : 0};
+
+  if ( ticks <= m_ticks )
+  {
+    return;
+  }
+
+  const uint_fast64_t elapsed {ticks - m_ticks};
+  // the shards are not summed atomically: a sum may miss marks an earlier
+  // one saw
+  const uint_fast64_t events {(count > m_tickedCount) ? (count - m_tickedCount) : 0};
+  // the events since the previous read, spread evenly over the elapsed ticks
+  const double rate {static_cast<double>(events) / (static_cast<double>(elapsed) * tickSeconds)};
+  const uint_fast64_t share {events / elapsed};
+  const uint_fast64_t remainder {events % elapsed};
+
+  // only the last ringSize ticks stay in the ring; the remainder goes to the
+  // last ones
+  for (uint_fast64_t&& i {elapsed - std::min<uint_fast64_t>(elapsed, ringSize)}; i < elapsed; ++i)
+  {
+    m_buckets[(m_ticks + i) % ringSize] = share + ((i >= (elapsed - remainder)) ? 1 : 0);
+  }
+  for (std::size_t&& i {0}; i < rateWindowsCount; ++i)
+  {
+    const double decay {std::exp(-tickSeconds / static_cast<double>(windowSeconds[i]))};
+
+    // elapsed ticks at the same rate, in closed form; the first tick starts
+    // the average at its rate
+    m_ewma[i] = (0 == m_ticks) ? rate : (rate + ((m_ewma[i] - rate) * std::pow(decay, static_cast<double>(elapsed))));
+  }
+  m_ticks = ticks;
+  m_tickedCount = std::max(m_tickedCount, count);
+}
+
+rateSnapshot
+rateMeter::snapshotAt(const uint_fast64_t tsc) const
+{
+  std::lock_guard<std::mutex> lock {m_mutex};
+  // under the lock: the reads tick in the order they sum the shards
+  const uint_fast64_t count {getCount()};
+  rateSnapshot s {};
+
+  tickTo(tsc, count);
+  s.count = count;
+  if ( tsc > m_start )
+  {
+    s.meanRate = static_cast<double>(count) / (static_cast<double>(tsc_clock::toNanoseconds(tsc - m_start)) / 1e9);
+  }
+  for (std::size_t&& i {0}; i < rateWindowsCount; ++i)
+  {
+    // a window longer than the life of the meter covers the ticks so far
+    const uint_fast64_t windowTicks {std::min<uint_fast64_t>(windowSeconds[i] * ticksPerSecond, m_ticks)};
+    uint_fast64_t events {0};
+
+    for (uint_fast64_t&& t {m_ticks - windowTicks}; t < m_ticks; ++t)
+    {
+      events += m_buckets[t % ringSize];
+    }
+    s.windowRates[i] = (0 == windowTicks) ? 0.0 : (static_cast<double>(events) / (static_cast<double>(windowTicks) * tickSeconds));
+    s.ewmaRates[i] = m_ewma[i];
+  }
+  return s;
+}
+
+void
+rateMeter::report(std::ostream& os) const
+{
+  os << m_name << ": " << snapshot() << '\n';
+}
+}  // namespace timeSupport
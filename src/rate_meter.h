@@ -0,0 +1,164 @@
+/*
+ * File:   rate_meter.h
+ * Author: massimo
+ *
+ * Created on October 24, 2026, 10:15 AM
+ */
+#pragma once
+
+#include "thread_shards.h"
+#include "tsc_clock.h"
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+// the windows of the sliding and of the moving average rates
+enum class rateWindow { ONE_SECOND, TEN_SECONDS, ONE_MINUTE };
+
+constexpr std::size_t rateWindowsCount {3};
+
+const char* rateWindowName(const rateWindow w) noexcept;
+
+// the rates of a meter as of one read, in events per second
+struct rateSnapshot
+{
+  uint_fast64_t count {};
+  // since the meter was created
+  double meanRate {};
+  // the events of the last complete ticks of the window, over the window
+  std::array<double, rateWindowsCount> windowRates {};
+  // exponentially weighted moving averages with the window as time constant
+  std::array<double, rateWindowsCount> ewmaRates {};
+
+  constexpr
+  double
+  windowRate(const rateWindow w) const noexcept
+  {
+    return windowRates[static_cast<std::size_t>(w)];
+  }
+
+  constexpr
+  double
+  ewmaRate(const rateWindow w) const noexcept
+  {
+    return ewmaRates[static_cast<std::size_t>(w)];
+  }
+};
+
+// count N, mean x/s, 1s x/s, 10s x/s, 1m x/s, EWMA 1s x/s, 10s x/s, 1m x/s
+std::ostream& operator<<(std::ostream& os, const rateSnapshot& obj);
+
+////////////////////////////////////////////////////////////////////////////////
+// counts events and tells how many per second
+// mark() bumps the calling thread's counter, in its own cache line: no
+// atomic read-modify-write, no shared cache line, no clock read
+// the rates are computed lazily by the reads: every tickInterval of TSC
+// time the sum of the counters is split into a ring of buckets (the sliding
+// windows) and fed to the moving averages; the events marked since the
+// previous read are spread evenly over the ticks elapsed since then, so a
+// read every few seconds gives the same rates for a steady load
+class rateMeter final
+{
+ public:
+  static constexpr std::chrono::milliseconds tickInterval {100};
+
+  explicit rateMeter(const std::string& name = "rateMeter");
+
+  rateMeter(const rateMeter&) = delete;
+  rateMeter& operator=(const rateMeter&) = delete;
+
+  // n events happened on the calling thread
+  void
+  mark(const uint_fast64_t n = 1)
+  {
+    auto&& count = m_shards.local().count;
+
+    // only this thread writes its counter
+    count.store(count.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  // the events marked by all the threads so far
+  uint_fast64_t getCount() const;
+
+  // the rates now
+  rateSnapshot
+  snapshot() const
+  {
+    return snapshotAt(stopTSC());
+  }
+
+  // the rates as of the given TSC: a TSC older than the one of the previous
+  // read does not move the ticks back
+  rateSnapshot snapshotAt(const uint_fast64_t tsc) const;
+
+  double
+  getMeanRate() const
+  {
+    return snapshot().meanRate;
+  }
+
+  double
+  getWindowRate(const rateWindow w) const
+  {
+    return snapshot().windowRate(w);
+  }
+
+  double
+  getEwmaRate(const rateWindow w) const
+  {
+    return snapshot().ewmaRate(w);
+  }
+
+  constexpr
+  uint_fast64_t
+  getStartTSC() const noexcept
+  {
+    return m_start;
+  }
+
+  // the ticks of a tickInterval
+  constexpr
+  uint_fast64_t
+  getTickTSC() const noexcept
+  {
+    return m_tickTicks;
+  }
+
+  // name: the rates now
+  void report(std::ostream& os = std::cout) const;
+
+  const std::string&
+  getName() const noexcept
+  {
+    return m_name;
+  }
+
+ private:
+  struct alignas(64) shard
+  {
+    std::atomic<uint_fast64_t> count {0};
+  };
+
+  // the longest window, in ticks
+  static constexpr std::size_t ringSize {600};
+
+  const std::string m_name {};
+  const uint_fast64_t m_tickTicks;
+  const uint_fast64_t m_start;
+  threadShards<shard> m_shards {};
+  // the lazily computed state, updated by the reads
+  mutable std::mutex m_mutex {};
+  mutable std::array<uint_fast64_t, ringSize> m_buckets {};
+  mutable uint_fast64_t m_ticks {0};
+  mutable uint_fast64_t m_tickedCount {0};
+  mutable std::array<double, rateWindowsCount> m_ewma {};
+
+  // with m_mutex held: move the ticks up to the ones complete at tsc
+  void tickTo(const uint_fast64_t tsc, const uint_fast64_t count) const;
+};  // class rateMeter
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
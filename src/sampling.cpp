@@ -0,0 +1,70 @@
+/*
+ * File:   sampling.cpp
+ * Author: massimo
+ *
+ * Created on October 26, 2026, 9:30 AM
+ */
+#include "sampling.h"
+#include "binary_trace.h"
+#include <cmath>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+namespace
+{
+// splitmix64: a 64-bit state, any seed is fine
+uint_fast64_t
+nextRandom(uint_fast64_t& state) noexcept
+{
+  uint64_t z {(state += 0x9E3779B97F4A7C15ULL)};
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+  return z ^ (z >> 31);
+}
+}  // namespace
+
+sampleCountdown::sampleCountdown(const uint_fast64_t period,
+                                 const samplingMode mode,
+                                 const uint_fast64_t seed) noexcept
+:
+m_period{(period > 1) ? period : 1},
+m_rng{seed},
+m_mode{mode}
+{
+  m_countdown = (samplingMode::FIXED == m_mode) ? m_period : drawGap();
+}
+
+uint_fast64_t
+sampleCountdown::drawGap() noexcept
+{
+  if ( 1 == m_period )
+  {
+    return 1;
+  }
+
+  // u in (0, 1], from the top 53 bits
+  const double u {static_cast<double>((nextRandom(m_rng) >> 11) + 1) * 0x1.0p-53};
+  const double gap {std::floor(std::log(u) / std::log1p(-1.0 / static_cast<double>(m_period)))};
+
+  return 1 + static_cast<uint_fast64_t>(gap);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+sampler::sampler(const uint_fast64_t period, const samplingMode mode)
+:
+m_period{(period > 1) ? period : 1},
+m_mode{mode},
+m_shards{[this] ()
+{
+  std::unique_ptr<shard> s {std::make_unique<shard>()};
+
+  // every thread draws its own gaps
+  s->countdown = sampleCountdown{m_period,
+                                 m_mode,
+                                 (static_cast<uint_fast64_t>(traceThreadId()) << 32) ^ reinterpret_cast<uintptr_t>(this)};
+  return s;
+}}
+{}
+}  // namespace timeSupport
@@ -0,0 +1,122 @@
+/*
+ * File:   sampling.h
+ * Author: massimo
+ *
+ * Created on October 26, 2026, 9:30 AM
+ */
+#pragma once
+
+#include "thread_shards.h"
+#include <cstdint>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+// FIXED times every period-th execution; GEOMETRIC draws the gap to the next
+// timed execution from a geometric distribution of mean period, so that the
+// samples cannot lock onto a pattern of the code
+enum class samplingMode { FIXED, GEOMETRIC };
+
+// decides which executions of a region are timed, for one thread
+// take() is a decrement and a compare; only a timed execution of the
+// GEOMETRIC mode draws the next gap; a timed execution stands for period
+// executions, so its weight is the period in both modes and the weighted
+// counts and sums estimate the ones of all the executions
+class sampleCountdown final
+{
+ public:
+  // every execution is timed
+  constexpr sampleCountdown() noexcept = default;
+
+  // a period of 0 or 1 times every execution; seed feeds the GEOMETRIC draws
+  sampleCountdown(const uint_fast64_t period,
+                  const samplingMode mode = samplingMode::FIXED,
+                  const uint_fast64_t seed = 0) noexcept;
+
+  // true when this execution is to be timed
+  bool
+  take() noexcept
+  {
+    if ( --m_countdown != 0 )
+    {
+      return false;
+    }
+    m_countdown = (samplingMode::FIXED == m_mode) ? m_period : drawGap();
+    return true;
+  }
+
+  constexpr
+  uint_fast64_t
+  getPeriod() const noexcept
+  {
+    return m_period;
+  }
+
+  // the executions a timed one stands for
+  constexpr
+  uint_fast64_t
+  getWeight() const noexcept
+  {
+    return m_period;
+  }
+
+  constexpr
+  samplingMode
+  getMode() const noexcept
+  {
+    return m_mode;
+  }
+
+ private:
+  uint_fast64_t m_period {1};
+  uint_fast64_t m_countdown {1};
+  uint_fast64_t m_rng {0};
+  samplingMode m_mode {samplingMode::FIXED};
+
+  // a GEOMETRIC gap
+  uint_fast64_t drawGap() noexcept;
+};  // class sampleCountdown
+
+////////////////////////////////////////////////////////////////////////////////
+// a sampleCountdown per thread, for the regions run by many threads, e.g. a
+// TIME_ZONE_SAMPLED() or the calls of profileFunction on a shared path
+class sampler final
+{
+ public:
+  explicit sampler(const uint_fast64_t period,
+                   const samplingMode mode = samplingMode::GEOMETRIC);
+
+  sampler(const sampler&) = delete;
+  sampler& operator=(const sampler&) = delete;
+
+  bool
+  take()
+  {
+    return m_shards.local().countdown.take();
+  }
+
+  constexpr
+  uint_fast64_t
+  getWeight() const noexcept
+  {
+    return m_period;
+  }
+
+  constexpr
+  samplingMode
+  getMode() const noexcept
+  {
+    return m_mode;
+  }
+
+ private:
+  struct alignas(64) shard
+  {
+    sampleCountdown countdown {};
+  };
+
+  const uint_fast64_t m_period;
+  const samplingMode m_mode;
+  threadShards<shard> m_shards;
+};  // class sampler
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
@@ -0,0 +1,95 @@
+/*
+ * File:   stage_statistics.cpp
+ * Author: massimo
+ *
+ * Created on October 19, 2026, 9:45 AM
+ */
+#include "stage_statistics.h"
+#include "time_support.h"
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+stageStatistics::stageStatistics(const std::string& name,
+                                 const std::size_t stagesCount)
+:
+m_name{name}
+{
+  m_stages.reserve(stagesCount);
+  for (std::size_t&& i {0}; i < stagesCount; ++i)
+  {
+    m_stages.push_back(std::make_unique<stage>(m_name + "[" + std::to_string(i) + "]"));
+  }
+}
+
+void
+stageStatistics::recordStage(const std::size_t i,
+                             const labelId from,
+                             const labelId to,
+                             const uint_fast64_t ticks,
+                             const uint_fast64_t n) noexcept
+{
+  if ( i >= m_stages.size() )
+  {
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  stage& s = *m_stages[i];
+  labelId expected {noLabel};
+
+  // the first run names the stage
+  if ( noLabel == s.to.load(std::memory_order_relaxed) )
+  {
+    s.from.compare_exchange_strong(expected, from, std::memory_order_relaxed);
+    expected = noLabel;
+    s.to.compare_exchange_strong(expected, to, std::memory_order_relaxed);
+  }
+  s.histogram.record(ticks, n);
+}
+
+void
+stageStatistics::record(const rdtscTimer& timer) noexcept
+{
+  const std::size_t laps {timer.getLapsCount()};
+  // a sampled run stands for weight runs
+  const uint_fast64_t weight {timer.getSampleWeight()};
+  labelId&& from {timer.getStartLabel().getId()};
+  uint_fast64_t&& previous {timer.getStartTSC()};
+
+  for (std::size_t&& i {0}; i < laps; ++i)
+  {
+    const labelId to {timer.getLapLabel(i).getId()};
+    const uint_fast64_t tsc {timer.getLapTSC(i)};
+
+    recordStage(i, from, to, tsc - previous, weight);
+    from = to;
+    previous = tsc;
+  }
+  recordStage(laps, from, timer.getStopLabel().getId(), timer.getStopTSC() - previous, weight);
+  m_runs.fetch_add(weight, std::memory_order_relaxed);
+}
+
+void
+stageStatistics::report(std::ostream& os) const
+{
+  os << m_name << ": " << getRuns() << " runs" << '\n';
+  for (std::size_t&& i {0}; i < m_stages.size(); ++i)
+  {
+    const tickHistogram&& h = snapshot(i);
+
+    if ( 0 == h.getCount() )
+    {
+      continue;
+    }
+    os << m_name << ": stage " << i << ": "
+       << labelName(getStageFrom(i)) << " -> "
+       << labelName(getStageTo(i)) << ": "
+       << h
+       << '\n';
+  }
+  if ( getDroppedStages() > 0 )
+  {
+    os << m_name << ": " << getDroppedStages() << " stages dropped: too many laps" << '\n';
+  }
+}
+}  // namespace timeSupport
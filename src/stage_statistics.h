@@ -0,0 +1,113 @@
+/*
+ * File:   stage_statistics.h
+ * Author: massimo
+ *
+ * Created on October 19, 2026, 9:45 AM
+ */
+#pragma once
+
+#include "labels.h"
+#include "latency_histogram.h"
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+class rdtscTimer;
+
+// per-stage latency histograms of many runs of a timer with laps
+// stage i of a run goes from the (i - 1)th lap (the start for i == 0) to the
+// ith lap (the stop for the last stage); stages are matched by position and
+// named after the labels of the first run recorded
+// all the histograms are created by the ctor and record() records into the
+// calling thread's shards, so timers on many threads can share the statistics
+class stageStatistics final
+{
+ public:
+  // stagesCount is the number of laps + 1 of the runs to record; extra stages
+  // are dropped and counted
+  explicit stageStatistics(const std::string& name = "stageStatistics",
+                           const std::size_t stagesCount = 17);
+
+  stageStatistics(const stageStatistics&) = delete;
+  stageStatistics& operator=(const stageStatistics&) = delete;
+
+  // add the stages of the stopped run of timer
+  void record(const rdtscTimer& timer) noexcept;
+
+  std::size_t
+  getStagesCount() const noexcept
+  {
+    return m_stages.size();
+  }
+
+  // merge all the threads' shards of stage i
+  tickHistogram
+  snapshot(const std::size_t i) const
+  {
+    return m_stages[i]->histogram.snapshot();
+  }
+
+  labelId
+  getStageFrom(const std::size_t i) const noexcept
+  {
+    return m_stages[i]->from.load(std::memory_order_relaxed);
+  }
+
+  labelId
+  getStageTo(const std::size_t i) const noexcept
+  {
+    return m_stages[i]->to.load(std::memory_order_relaxed);
+  }
+
+  uint_fast64_t
+  getRuns() const noexcept
+  {
+    return m_runs.load(std::memory_order_relaxed);
+  }
+
+  uint_fast64_t
+  getDroppedStages() const noexcept
+  {
+    return m_dropped.load(std::memory_order_relaxed);
+  }
+
+  // one line per stage recorded: from -> to and its percentiles
+  void report(std::ostream& os = std::cout) const;
+
+  const std::string&
+  getName() const noexcept
+  {
+    return m_name;
+  }
+
+ private:
+  struct stage
+  {
+    explicit stage(const std::string& name)
+    :
+    histogram{name}
+    {}
+
+    latencyHistogram histogram;
+    std::atomic<labelId> from {noLabel};
+    std::atomic<labelId> to {noLabel};
+  };
+
+  const std::string m_name {};
+  std::vector<std::unique_ptr<stage>> m_stages {};
+  std::atomic<uint_fast64_t> m_runs {0};
+  std::atomic<uint_fast64_t> m_dropped {0};
+
+  void recordStage(const std::size_t i,
+                   const labelId from,
+                   const labelId to,
+                   const uint_fast64_t ticks,
+                   const uint_fast64_t n) noexcept;
+};  // class stageStatistics
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
@@ -0,0 +1,113 @@
+/*
+ * File:   thread_shards.h
+ * Author: massimo
+ *
+ * Created on October 16, 2026, 11:40 AM
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+// one shard per thread for each owner object
+// the calling thread finds its shard in a thread_local table indexed by the
+// owner id, so after the first access from a thread local() neither locks
+// nor allocates; shards are kept alive until the owner is destroyed, so the
+// samples of threads that have exited are not lost
+// owner ids are never reused: the thread_local table grows with the number
+// of owners created in the process
+template <typename shardType>
+class threadShards final
+{
+ public:
+  using factoryType = std::function<std::unique_ptr<shardType>()>;
+
+  threadShards()
+  :
+  threadShards([] () { return std::make_unique<shardType>(); })
+  {}
+
+  // the factory creates the shard of a thread on its first access
+  explicit threadShards(factoryType factory)
+  :
+  m_id{m_nextId.fetch_add(1, std::memory_order_relaxed)},
+  m_factory{std::move(factory)}
+  {}
+
+  threadShards(const threadShards&) = delete;
+  threadShards& operator=(const threadShards&) = delete;
+
+  shardType&
+  local()
+  {
+    if ( (m_id < m_threadTable.size()) && (nullptr != m_threadTable[m_id]) )
+    {
+      return *static_cast<shardType*>(m_threadTable[m_id]);
+    }
+    return registerLocal();
+  }
+
+  // visit all the shards; threads may keep recording while visited
+  template <typename F>
+  void
+  forEach(F&& f) const
+  {
+    std::lock_guard<std::mutex> lock {m_mutex};
+
+    for (auto&& s : m_shards)
+    {
+      f(static_cast<const shardType&>(*s));
+    }
+  }
+
+  template <typename F>
+  void
+  forEach(F&& f)
+  {
+    std::lock_guard<std::mutex> lock {m_mutex};
+
+    for (auto&& s : m_shards)
+    {
+      f(*s);
+    }
+  }
+
+  std::size_t
+  size() const
+  {
+    std::lock_guard<std::mutex> lock {m_mutex};
+
+    return m_shards.size();
+  }
+
+ private:
+  inline static std::atomic<std::size_t> m_nextId {0};
+  inline static thread_local std::vector<void*> m_threadTable {};
+  const std::size_t m_id;
+  const factoryType m_factory;
+  mutable std::mutex m_mutex {};
+  std::vector<std::unique_ptr<shardType>> m_shards {};
+
+  shardType&
+  registerLocal()
+  {
+    std::lock_guard<std::mutex> lock {m_mutex};
+
+    m_shards.push_back(m_factory());
+    if ( m_id >= m_threadTable.size() )
+    {
+      m_threadTable.resize(m_id + 1, nullptr);
+    }
+    m_threadTable[m_id] = m_shards.back().get();
+
+    return *m_shards.back();
+  }
+};  // class threadShards
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
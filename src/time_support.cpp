@@ -10,12 +10,14 @@
 #pragma clang diagnostic ignored "-Wglobal-constructors"
 ////////////////////////////////////////////////////////////////////////////////
 #include "time_support.h"
+#include "async_report_sink.h"
 #include <iomanip>
 ////////////////////////////////////////////////////////////////////////////////
 namespace timeSupport
 {
 const std::string rdtscTimer::m_startPointLabelDefault{"-CTOR-START"};
 const std::string rdtscTimer::m_stopPointLabelDefault{"-DTOR-STOP"};
+const std::string nullTimer::m_inactiveStatus{"INACTIVE"};
 
 std::unordered_map<rdtscTimer::mapKey, std::string> rdtscTimer::timerStatusStringMap {
     {static_cast<rdtscTimer::mapKey>(rdtscTimer::rdtscTimerStatus::INACTIVE), "INACTIVE"},
@@ -28,6 +30,7 @@ rdtscTimer::rdtscTimer(const std::string& timerName,
                        std::ostream& log) noexcept
 :
 m_timerName{timerName},
+m_timerId{internLabel(m_timerName)},
 m_startPointLabel(m_timerName + m_startPointLabelDefault),
 m_stopPointLabel(m_timerName + m_stopPointLabelDefault),
 m_rdtscTimerStatus(rdtscTimerStatus::INACTIVE),
@@ -36,13 +39,14 @@ m_log(log)
 
 rdtscTimer::~rdtscTimer() noexcept
 {
-  // take the stop time and store it in temporary vars, in case it is needed later
-  uint_fast64_t&& stop = rdtscp();
-#ifdef CHRONO_TIME
-  std::chrono::high_resolution_clock::time_point&& tstop = std::chrono::high_resolution_clock::now();
-#endif
+  // take the stop tick and store it in a temporary var, in case it is needed later
+  uint32_t stopCpu {unknownCpu};
+  uint_fast64_t&& stop = stopTSC(stopCpu);
   auto&& s = getTimerStatus();
 
+  // give the slot back before anything else: the run ends here
+  watchWith(nullptr);
+
   // if inactive then leave
   if ( rdtscTimerStatus::INACTIVE == s )
   {
@@ -52,11 +56,14 @@ rdtscTimer::~rdtscTimer() noexcept
   if ( rdtscTimerStatus::STARTED == s )
   {
     m_stop  = stop;
-#ifdef CHRONO_TIME
-    m_tstop = tstop;
-#endif
+    m_stopCpu = stopCpu;
+    if ( nullptr != m_counters )
+    {
+      m_countersStop = m_counters->read();
+    }
     s = rdtscTimerStatus::STOPPED;
     setTimerStatus(s);
+    recordSample();
   }
   if ( rdtscTimerStatus::STOPPED == s )
   {
@@ -65,29 +72,88 @@ rdtscTimer::~rdtscTimer() noexcept
   }
 }
 
+rdtscTimer&
+rdtscTimer::watchWith(deadlineWatchdog* watchdog)
+{
+  if ( nullptr != m_watchdog )
+  {
+    m_watchdog->release(m_watchSlot);
+    m_watchSlot = nullptr;
+  }
+  m_watchdog = watchdog;
+  if ( nullptr != m_watchdog )
+  {
+    m_watchSlot = m_watchdog->acquire(m_timerId);
+    // a running timer is watched from now on
+    if ( rdtscTimerStatus::STARTED == getTimerStatus() )
+    {
+      m_watchSlot->begin(m_start, m_budget, m_startPointLabel.getId(), traceThreadId(), m_startCpu);
+    }
+  }
+  return *this;
+}
+
+void
+rdtscTimer::budgetExceeded() noexcept
+{
+  ++m_overBudget;
+  if ( m_onOverBudget )
+  {
+    m_onOverBudget({m_timerId,
+                    m_startPointLabel.getId(),
+                    m_stopPointLabel.getId(),
+                    m_start,
+                    m_stop,
+                    m_budget,
+                    traceThreadId(),
+                    m_startCpu,
+                    m_stopCpu});
+  }
+}
+
 rdtscTimer&
 rdtscTimer::report() noexcept
 {
+  // nothing was timed since the last report; a run stopped before the
+  // latest start() left out by the sampling is still reported
+  if ( m_sampledOut && (rdtscTimerStatus::STOPPED != getTimerStatus()) )
+  {
+    return *this;
+  }
   if ( rdtscTimerStatus::STOPPED == getTimerStatus() )
   {
-    m_log << m_timerName << ": " << m_startPointLabel << " -> " << m_stopPointLabel
-          << ": Timer started at "
-          << m_start
-          <<  " and stopped at "
-          << m_stop
-          << " taking "
-          << m_stop - m_start
-          << " ticks"
-#ifdef CHRONO_TIME
-          << " [ "
-          <<  std::setprecision(16)
-          << getStopLapsed_sec()
-          << " sec = "
-          << getStopLapsed_nsec()
-          << std::setprecision(5)
-          << " nsec ]"
-#endif
-          << '\n';
+    // in histogram, trace or stage mode the sample was already recorded by stop()
+    if ( (nullptr != m_histogram) || (nullptr != m_trace) || (nullptr != m_stages) )
+    {
+      setTimerStatus(rdtscTimerStatus::REPORTED);
+      return *this;
+    }
+
+    if ( nullptr != m_sink )
+    {
+      m_sink->push({m_timerId,
+                    m_startPointLabel.getId(),
+                    m_stopPointLabel.getId(),
+                    m_start,
+                    m_stop,
+                    getMeasurementOverhead(),
+                    m_startCpu,
+                    m_stopCpu,
+                    getCountersDelta()});
+      setTimerStatus(rdtscTimerStatus::REPORTED);
+      return *this;
+    }
+
+    writeReport(m_log,
+                m_timerName,
+                m_startPointLabel.getName(),
+                m_stopPointLabel.getName(),
+                m_start,
+                m_stop,
+                getMeasurementOverhead(),
+                m_startCpu,
+                m_stopCpu,
+                getCountersDelta());
 
     setTimerStatus(rdtscTimerStatus::REPORTED);
 
@@ -101,6 +167,114 @@ rdtscTimer::report() noexcept
   return *this;
 }
 
+void
+rdtscTimer::writeReport(std::ostream& os,
+                        const std::string& timerName,
+                        const std::string& startPoint,
+                        const std::string& stopPoint,
+                        const uint_fast64_t start,
+                        const uint_fast64_t stop,
+                        const uint_fast64_t overhead,
+                        const uint32_t startCpu,
+                        const uint32_t stopCpu,
+                        const perfCounterValues& counters)
+{
+  const uint_fast64_t lapsed {stop - start};
+  const uint_fast64_t corrected {(lapsed > overhead) ? (lapsed - overhead) : 0};
+
+  os << timerName << ": " << startPoint << " -> " << stopPoint
+     << ": Timer started at "
+     << start
+     <<  " and stopped at "
+     << stop
+     << " taking "
+     << lapsed
+     << " ticks ("
+     << corrected
+     << " ticks corrected for an overhead of "
+     << overhead
+     << " ticks)"
+     << " [ "
+     <<  std::setprecision(16)
+     << std::chrono::duration_cast<std::chrono::duration<double>>(tsc_clock::toDuration(lapsed)).count()
+     << " sec = "
+     << tsc_clock::toNanoseconds(lapsed)
+     << std::setprecision(5)
+     << " nsec, corrected "
+     << tsc_clock::toNanoseconds(corrected)
+     << " nsec ]"
+     ;
+  if ( (unknownCpu != startCpu) && (unknownCpu != stopCpu) && (startCpu != stopCpu) )
+  {
+    os << " CROSS-CORE: cpu "
+       << startCpu
+       << " -> cpu "
+       << stopCpu;
+  }
+  if ( 0 != counters.available )
+  {
+    os << " PMU: " << counters;
+  }
+  os << '\n';
+}
+
+void
+rdtscTimer::writeLaps(std::ostream& os) const
+{
+  const timeLabel* from {&m_startPointLabel};
+  uint_fast64_t previous {m_start};
+
+  for (std::size_t&& i {0}; i <= m_lapsCount; ++i)
+  {
+    const bool last {m_lapsCount == i};
+    const timeLabel& to = last ? m_stopPointLabel : m_laps[i].label;
+    const uint_fast64_t tsc {last ? m_stop : m_laps[i].tsc};
+
+    os << m_timerName << ": lap " << i << ": "
+       << *from << " -> " << to << ": "
+       << tsc - previous << " ticks [ "
+       << tsc_clock::toNanoseconds(tsc - previous) << " nsec ]"
+       << '\n';
+    from = &to;
+    previous = tsc;
+  }
+}
+
+uint_fast64_t
+rdtscTimer::getMeasurementOverhead() noexcept
+{
+  static thread_local const uint_fast64_t overhead {calibrateMeasurementOverhead()};
+
+  return overhead;
+}
+
+uint_fast64_t
+rdtscTimer::calibrateMeasurementOverhead(const unsigned int samples) noexcept
+{
+  constexpr unsigned int warmUp {1'000};
+  std::ostream nullLog {nullptr};
+  latencyHistogram histogram {"measurementOverhead"};
+
+  {
+    // left in histogram mode: its dtor must not report
+    rdtscTimer rdtsct {"measurementOverhead", nullLog};
+
+    for (unsigned int&& i {0}; i < warmUp; ++i)
+    {
+      rdtsct.start().stop(timeLabel{});
+    }
+    rdtsct.recordInto(&histogram);
+    for (unsigned int&& i {0}; i < samples; ++i)
+    {
+      rdtsct.start().stop(timeLabel{});
+    }
+  }
+
+  // a low percentile rather than the minimum: robust to a lucky sample,
+  // while interrupts and migrations only hit the upper tail
+  return histogram.snapshot().percentile(0.05);
+}
+
 // extraction operator for class rdtscTimer
 std::ostream& operator<<(std::ostream& os, const rdtscTimer& obj)
 {
@@ -124,14 +298,36 @@ std::ostream& operator<<(std::ostream& os, const rdtscTimer& obj)
      << "> Stop Tick:  "
      << obj.m_stop
      << '\n'
-#ifdef CHRONO_TIME
+     << "> Start CPU: "
+     << obj.m_startCpu
+     << '\n'
+     << "> Stop CPU:  "
+     << obj.m_stopCpu
+     << '\n'
+     << "> Clock: "
+     << clockBackendName(activeClockBackend())
+     << '\n'
      << "> Start Time Point: "
-     << obj.m_tstart.time_since_epoch().count()
+     << tsc_clock::fromTicks(obj.m_start).time_since_epoch().count()
      << '\n'
      << "> Stop Time Point:  "
-     << obj.m_tstop.time_since_epoch().count()
-#endif
+     << tsc_clock::fromTicks(obj.m_stop).time_since_epoch().count()
      ;
+  if ( nullptr != obj.m_counters )
+  {
+    os << '\n'
+       << "> Counters: "
+       << obj.getCountersDelta();
+  }
+  if ( UINT_FAST64_MAX != obj.m_budget )
+  {
+    os << '\n'
+       << "> Budget: "
+       << obj.m_budget
+       << " ticks, exceeded "
+       << obj.m_overBudget
+       << " times";
+  }
 
   return os;
 }
@@ -144,6 +340,13 @@ std::ostream& operator<<(std::ostream& os, const rdtscTimer& obj)
 //    is.setstate(std::ios::failbit);
 //  return is;
 //}
+
+namespace
+{
+// take the main thread's measure when the process starts
+[[maybe_unused]]
+const uint_fast64_t startupMeasurementOverhead {rdtscTimer::getMeasurementOverhead()};
+}  // namespace
 }  // namespace timeSupport
 ////////////////////////////////////////////////////////////////////////////////
 #pragma clang diagnostic pop
@@ -10,36 +10,22 @@
 #include <chrono>
 #include <unordered_map>
 #include <functional>
-////////////////////////////////////////////////////////////////////////////////
-#ifndef CHRONO_TIME
-#define CHRONO_TIME
-#endif
+#include "tsc_clock.h"
+#include "latency_histogram.h"
+#include "labels.h"
+#include "binary_trace.h"
+#include "time_zones.h"
+#include "call_tree.h"
+#include "stage_statistics.h"
+#include "perf_counters.h"
+#include "tsc_skew.h"
+#include "latency_budget.h"
+#include "sampling.h"
+#include <array>
 ////////////////////////////////////////////////////////////////////////////////
 namespace timeSupport
 {
-inline
-uint_fast64_t
-rdtscp() noexcept
-{
-  volatile uint_fast32_t tickl {};
-  volatile uint_fast32_t tickh {};
-
-  __asm__ __volatile__("rdtscp" : "=a"(tickl), "=d"(tickh) ::);
-
-  return ((static_cast<uint_fast64_t>(tickh) << 32) | tickl);
-}
-
-inline
-void
-rdtscp(uint_fast64_t& r) noexcept
-{
-  volatile uint_fast32_t tickl {};
-  volatile uint_fast32_t tickh {};
-
-  __asm__ __volatile__("rdtscp" : "=a"(tickl), "=d"(tickh) ::);
-
-  r = (static_cast<uint_fast64_t>(tickh) << 32) | tickl;
-}
+class asyncReportSink;
 ////////////////////////////////////////////////////////////////////////////////
 class rdtscTimer final
 {
@@ -48,14 +34,26 @@ class rdtscTimer final
  public:
   enum class rdtscTimerStatus { INACTIVE, STARTED, STOPPED, REPORTED };
 
+  // what the histogram does with a sample whose start and stop were read on
+  // different CPUs: the ticks of two cores are compared and can be wrong
+  enum class crossCorePolicy { KEEP, DROP };
+
   explicit rdtscTimer(const std::string& timerName = "rdtscTimer",
                       std::ostream& log = std::cout) noexcept;
 
   ~rdtscTimer() noexcept;
 
+  // a watched timer owns a slot of its watchdog
+  rdtscTimer(const rdtscTimer&) = delete;
+  rdtscTimer& operator=(const rdtscTimer&) = delete;
+
+  // the TSC reads are fenced as the readPolicy says (see tsc_clock.h):
+  // start<tscCpuidSerialized>() ... stop<tscCpuidSerialized>() for the most
+  // precise region, start<tscRdtsc>() ... stop<tscRdtsc>() for the cheapest
+  template <typename readPolicy = defaultReadPolicy>
   constexpr
   rdtscTimer&
-  start(const std::string& startPoint = "") noexcept
+  start(const timeLabel startPoint = timeLabel{}) noexcept
   {
     auto&& s = getTimerStatus();
 
@@ -64,15 +62,27 @@ class rdtscTimer final
          (rdtscTimerStatus::STOPPED == s)
        )
     {
+      // a run left out by the sampling reads no clock
+      m_sampledOut = !m_sampling.take();
+      if ( m_sampledOut )
+      {
+        return *this;
+      }
       setTimerStatus(rdtscTimerStatus::STARTED);
-      if ( "" != startPoint )
+      if ( !startPoint.empty() )
       {
         m_startPointLabel = startPoint;
       }
-#ifdef CHRONO_TIME
-      m_tstart = std::chrono::high_resolution_clock::now();
-#endif
-      m_start = rdtscp();
+      m_lapsCount = 0;
+      if ( nullptr != m_counters )
+      {
+        m_countersStart = m_counters->read();
+      }
+      m_start = startTSC<readPolicy>(m_startCpu);
+      if ( nullptr != m_watchSlot )
+      {
+        m_watchSlot->begin(m_start, m_budget, m_startPointLabel.getId(), traceThreadId(), m_startCpu);
+      }
       return *this;
     }
     
@@ -84,18 +94,25 @@ class rdtscTimer final
     return *this;
   }
 
+  template <typename readPolicy = defaultReadPolicy>
   constexpr
   rdtscTimer&
-  stop(const std::string& stopPoint) noexcept
+  stop(const timeLabel stopPoint) noexcept
   {
+    if ( m_sampledOut )
+    {
+      return *this;
+    }
     if ( rdtscTimerStatus::STARTED == getTimerStatus() )
     {
-      m_stop = rdtscp();
-#ifdef CHRONO_TIME
-      m_tstop = std::chrono::high_resolution_clock::now();
-#endif
+      m_stop = stopTSC<readPolicy>(m_stopCpu);
+      if ( nullptr != m_counters )
+      {
+        m_countersStop = m_counters->read();
+      }
       setTimerStatus(rdtscTimerStatus::STOPPED);
-      m_stopPointLabel = std::move(stopPoint);
+      m_stopPointLabel = stopPoint;
+      recordSample();
       return *this;
     }
     
@@ -108,13 +125,314 @@ class rdtscTimer final
   }
 
   void
-  stopAndReport(const std::string& stopPoint) noexcept
+  stopAndReport(const timeLabel stopPoint) noexcept
   {
     stop(stopPoint).report();
   }
 
+  // record an intermediate checkpoint of the running timer into a fixed
+  // array: the time between two laps is a stage of the run; the laps are
+  // cleared by start() and the ones after the first maxLaps are dropped
+  template <typename readPolicy = defaultReadPolicy>
+  rdtscTimer&
+  lap(const timeLabel lapPoint) noexcept
+  {
+    if ( m_sampledOut )
+    {
+      return *this;
+    }
+    if ( rdtscTimerStatus::STARTED == getTimerStatus() )
+    {
+      const uint_fast64_t tsc {stopTSC<readPolicy>()};
+
+      if ( m_lapsCount < maxLaps )
+      {
+        m_laps[m_lapsCount] = {lapPoint, tsc};
+        ++m_lapsCount;
+      }
+      else
+      {
+        ++m_droppedLaps;
+      }
+      return *this;
+    }
+
+    m_log << m_timerName << ": "
+          << lapPoint
+          << ": ERROR: lap() called but timer is not started"
+          << '\n';
+
+    return *this;
+  }
+
+  static constexpr std::size_t maxLaps {16};
+
+  constexpr
+  std::size_t
+  getLapsCount() const noexcept
+  {
+    return m_lapsCount;
+  }
+
+  const timeLabel&
+  getLapLabel(const std::size_t i) const noexcept
+  {
+    return m_laps[i].label;
+  }
+
+  constexpr
+  uint_fast64_t
+  getLapTSC(const std::size_t i) const noexcept
+  {
+    return m_laps[i].tsc;
+  }
+
+  // the ticks from the previous lap (or the start) to lap i
+  constexpr
+  uint_fast64_t
+  getLapDeltaTSC(const std::size_t i) const noexcept
+  {
+    return m_laps[i].tsc - ((0 == i) ? m_start : m_laps[i - 1].tsc);
+  }
+
+  // laps dropped since the timer was created: more than maxLaps in a run
+  constexpr
+  uint_fast64_t
+  getDroppedLaps() const noexcept
+  {
+    return m_droppedLaps;
+  }
+
+  // one line per stage of the last run: from -> to, ticks and nsec
+  void writeLaps(std::ostream& os) const;
+
   rdtscTimer& report() noexcept;
 
+  // histogram recording mode: every stop() adds the lapsed ticks to the
+  // calling thread's shard of the histogram and report() writes nothing;
+  // pass nullptr to go back to the line-per-report mode
+  constexpr
+  rdtscTimer&
+  recordInto(latencyHistogram* histogram) noexcept
+  {
+    m_histogram = histogram;
+    return *this;
+  }
+
+  constexpr
+  latencyHistogram*
+  getHistogram() const noexcept
+  {
+    return m_histogram;
+  }
+
+  // binary trace mode: every stop() appends a record to the trace and
+  // report() writes nothing; pass nullptr to go back to the line-per-report mode
+  constexpr
+  rdtscTimer&
+  traceTo(traceWriter* trace) noexcept
+  {
+    m_trace = trace;
+    return *this;
+  }
+
+  constexpr
+  traceWriter*
+  getTrace() const noexcept
+  {
+    return m_trace;
+  }
+
+  // asynchronous report mode: report() pushes the raw record into the sink
+  // and the sink's thread writes the line; pass nullptr to write to the log
+  constexpr
+  rdtscTimer&
+  reportTo(asyncReportSink* sink) noexcept
+  {
+    m_sink = sink;
+    return *this;
+  }
+
+  constexpr
+  asyncReportSink*
+  getReportSink() const noexcept
+  {
+    return m_sink;
+  }
+
+  // stage recording mode: every stop() adds the stages of the run to the
+  // statistics and report() writes nothing; pass nullptr to go back to the
+  // line-per-report mode
+  constexpr
+  rdtscTimer&
+  recordStagesInto(stageStatistics* stages) noexcept
+  {
+    m_stages = stages;
+    return *this;
+  }
+
+  constexpr
+  stageStatistics*
+  getStageStatistics() const noexcept
+  {
+    return m_stages;
+  }
+
+  // read the counters at start and stop too, so that the reports include the
+  // counts, IPC and miss rates of the region; the counters must belong to the
+  // thread running the timer; pass nullptr to detach them
+  constexpr
+  rdtscTimer&
+  attachCounters(perfCounterGroup* counters) noexcept
+  {
+    m_counters = counters;
+    return *this;
+  }
+
+  constexpr
+  perfCounterGroup*
+  getCounters() const noexcept
+  {
+    return m_counters;
+  }
+
+  // the counts from start to stop, none available without counters
+  perfCounterValues
+  getCountersDelta() const noexcept
+  {
+    if ( nullptr == m_counters )
+    {
+      return perfCounterValues{};
+    }
+    return m_countersStop - m_countersStart;
+  }
+
+  // KEEP (the default) records the cross-core samples in the histogram as
+  // any other sample, DROP leaves them out; they are counted either way
+  constexpr
+  rdtscTimer&
+  setCrossCorePolicy(const crossCorePolicy p) noexcept
+  {
+    m_crossCorePolicy = p;
+    return *this;
+  }
+
+  constexpr
+  crossCorePolicy
+  getCrossCorePolicy() const noexcept
+  {
+    return m_crossCorePolicy;
+  }
+
+  // budget mode: stop() compares the ticks of the region with the budget
+  // and, only when they exceed it, counts the region and passes an exemplar
+  // of it to onExceeded (e.g. exemplarLog::recorder()), on this thread;
+  // onExceeded must not throw
+  rdtscTimer&
+  setBudget(const uint_fast64_t ticks, budgetCallback onExceeded = budgetCallback{})
+  {
+    m_budget = ticks;
+    m_onOverBudget = std::move(onExceeded);
+    return *this;
+  }
+
+  rdtscTimer&
+  clearBudget() noexcept
+  {
+    return setBudget(UINT_FAST64_MAX);
+  }
+
+  // UINT_FAST64_MAX when no budget is set
+  constexpr
+  uint_fast64_t
+  getBudget() const noexcept
+  {
+    return m_budget;
+  }
+
+  // sampling mode: start() times only one run in period (see sampling.h);
+  // the runs left out read no clock and their stop(), lap() and report() do
+  // nothing; a timed run is recorded with the period as weight, so that the
+  // histogram and the stage statistics estimate the counts of all the runs;
+  // a period of 1 times every run
+  rdtscTimer&
+  sampleEvery(const uint_fast64_t period, const samplingMode mode = samplingMode::FIXED) noexcept
+  {
+    m_sampling = sampleCountdown{period, mode, reinterpret_cast<uintptr_t>(this)};
+    m_sampledOut = false;
+    return *this;
+  }
+
+  // the runs a timed run stands for, 1 without sampling
+  constexpr
+  uint_fast64_t
+  getSampleWeight() const noexcept
+  {
+    return m_sampling.getWeight();
+  }
+
+  // true when the sampling left the current (or last) run out
+  constexpr
+  bool
+  isSampledOut() const noexcept
+  {
+    return m_sampledOut;
+  }
+
+  // the regions over budget since the timer was created
+  constexpr
+  uint_fast64_t
+  getOverBudgetCount() const noexcept
+  {
+    return m_overBudget;
+  }
+
+  // let the watchdog flag the runs still going past start + budget; pass
+  // nullptr to stop watching; the watchdog must outlive the timer
+  rdtscTimer& watchWith(deadlineWatchdog* watchdog);
+
+  constexpr
+  deadlineWatchdog*
+  getWatchdog() const noexcept
+  {
+    return m_watchdog;
+  }
+
+  // write one report line as report() does; the line is marked CROSS-CORE
+  // when both CPUs are known and differ, and ends with the counters of the
+  // region when any is available
+  static void writeReport(std::ostream& os,
+                          const std::string& timerName,
+                          const std::string& startPoint,
+                          const std::string& stopPoint,
+                          const uint_fast64_t start,
+                          const uint_fast64_t stop,
+                          const uint_fast64_t overhead,
+                          const uint32_t startCpu = unknownCpu,
+                          const uint32_t stopCpu = unknownCpu,
+                          const perfCounterValues& counters = perfCounterValues{});
+
+  // the ticks an empty start() -> stop() region measures on the calling
+  // thread with the default read policy; measured on the first call from
+  // each thread (at startup for the main thread) as a low percentile of many
+  // empty regions
+  static uint_fast64_t getMeasurementOverhead() noexcept;
+
+  // measure the empty start() -> stop() cost now, on the calling thread
+  static uint_fast64_t calibrateMeasurementOverhead(const unsigned int samples = 10'000) noexcept;
+
+  const timeLabel&
+  getStartLabel() const noexcept
+  {
+    return m_startPointLabel;
+  }
+
+  const timeLabel&
+  getStopLabel() const noexcept
+  {
+    return m_stopPointLabel;
+  }
+
   constexpr
   uint_fast64_t
   getStartTSC() const noexcept
@@ -129,13 +447,47 @@ class rdtscTimer final
     return m_stop;
   }
 
+  // the CPUs that read the start and the stop ticks, from TSC_AUX;
+  // unknownCpu when the read policy does not use rdtscp
+  constexpr
+  uint32_t
+  getStartCpu() const noexcept
+  {
+    return m_startCpu;
+  }
+
+  constexpr
+  uint32_t
+  getStopCpu() const noexcept
+  {
+    return m_stopCpu;
+  }
+
+  // true when the last sample was started and stopped on different CPUs
+  constexpr
+  bool
+  isCrossCore() const noexcept
+  {
+    return (unknownCpu != m_startCpu) &&
+           (unknownCpu != m_stopCpu) &&
+           (m_startCpu != m_stopCpu);
+  }
+
+  // how many of the samples of this timer were cross-core
+  constexpr
+  uint_fast64_t
+  getCrossCoreSamples() const noexcept
+  {
+    return m_crossCoreSamples;
+  }
+
   constexpr
   uint_fast64_t
   getLapsedTSC() const noexcept
   {
     if ( rdtscTimerStatus::STARTED == getTimerStatus() )
     {
-      return (rdtscp() - m_start);
+      return (stopTSC() - m_start);
     }
     return 0;
   }
@@ -154,8 +506,43 @@ class rdtscTimer final
     return 0;
   }
 
-#ifdef CHRONO_TIME
-  constexpr
+  // the lapsed ticks minus the measurement overhead of the calling thread
+  uint_fast64_t
+  getStopLapsedTSCCorrected() const noexcept
+  {
+    const uint_fast64_t lapsed {getStopLapsedTSC()};
+    const uint_fast64_t overhead {getMeasurementOverhead()};
+
+    return (lapsed > overhead) ? (lapsed - overhead) : 0;
+  }
+
+  // the lapsed ticks of a cross-core sample with the stop moved back to the
+  // TSC of the start CPU, as measured by measureTscSkewMatrix(); the same as
+  // getStopLapsedTSC() when the CPUs are the same, unknown or not in skew
+  uint_fast64_t
+  getStopLapsedTSCSkewCorrected(const tscSkewMatrix& skew) const noexcept
+  {
+    if ( (!isCrossCore()) || (!skew.has(m_startCpu)) || (!skew.has(m_stopCpu)) )
+    {
+      return getStopLapsedTSC();
+    }
+
+    auto&& s = getTimerStatus();
+
+    if ( (rdtscTimerStatus::STOPPED == s) ||
+         (rdtscTimerStatus::REPORTED == s) )
+    {
+      return skew.correctedDelta(m_startCpu, m_stopCpu, m_start, m_stop);
+    }
+    return 0;
+  }
+
+  uint_fast64_t
+  getStopLapsed_nsecCorrected() const noexcept
+  {
+    return tsc_clock::toNanoseconds(getStopLapsedTSCCorrected());
+  }
+
   double
   getStopLapsed_sec() const noexcept
   {
@@ -164,14 +551,11 @@ class rdtscTimer final
     if ( (rdtscTimerStatus::STOPPED == s) ||
          (rdtscTimerStatus::REPORTED == s) )
     {
-      return std::chrono::duration_cast<std::chrono::duration<double>>(m_tstop - m_tstart).count();
+      return std::chrono::duration_cast<std::chrono::duration<double>>(tsc_clock::toDuration(m_stop - m_start)).count();
     }
     return 0;
   }
-#endif
 
-#ifdef CHRONO_TIME
-  constexpr
   uint_fast64_t
   getStopLapsed_msec() const noexcept
   {
@@ -180,14 +564,11 @@ class rdtscTimer final
     if ( (rdtscTimerStatus::STOPPED == s) ||
          (rdtscTimerStatus::REPORTED == s) )
     {
-      return static_cast<uint_fast64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(m_tstop - m_tstart).count());
+      return static_cast<uint_fast64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(tsc_clock::toDuration(m_stop - m_start)).count());
     }
     return 0;
   }
-#endif
 
-#ifdef CHRONO_TIME
-  constexpr
   uint_fast64_t
   getStopLapsed_usec() const noexcept
   {
@@ -196,14 +577,11 @@ class rdtscTimer final
     if ( (rdtscTimerStatus::STOPPED == s) ||
          (rdtscTimerStatus::REPORTED == s) )
     {
-      return static_cast<uint_fast64_t>(std::chrono::duration_cast<std::chrono::microseconds>(m_tstop - m_tstart).count());
+      return static_cast<uint_fast64_t>(std::chrono::duration_cast<std::chrono::microseconds>(tsc_clock::toDuration(m_stop - m_start)).count());
     }
     return 0;
   }
-#endif
 
-#ifdef CHRONO_TIME
-  constexpr
   uint_fast64_t
   getStopLapsed_nsec() const noexcept
   {
@@ -212,11 +590,10 @@ class rdtscTimer final
     if ( (rdtscTimerStatus::STOPPED == s) ||
          (rdtscTimerStatus::REPORTED == s) )
     {
-      return static_cast<uint_fast64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(m_tstop - m_tstart).count());
+      return tsc_clock::toNanoseconds(m_stop - m_start);
     }
     return 0;
   }
-#endif
 
   const std::string&
   getTimerStatusString() const noexcept
@@ -247,29 +624,557 @@ class rdtscTimer final
   static const std::string m_startPointLabelDefault;
   static const std::string m_stopPointLabelDefault;
   const std::string m_timerName{};
-  mutable std::string m_startPointLabel{};
-  mutable std::string m_stopPointLabel{};
+  const labelId m_timerId{};
+  timeLabel m_startPointLabel{};
+  timeLabel m_stopPointLabel{};
   mutable rdtscTimerStatus m_rdtscTimerStatus{rdtscTimerStatus::INACTIVE};
   uint_fast64_t m_start{};
   uint_fast64_t m_stop{};
-#ifdef CHRONO_TIME
-  std::chrono::high_resolution_clock::time_point m_tstart{};
-  std::chrono::high_resolution_clock::time_point m_tstop{};
-#endif
+  uint32_t m_startCpu{unknownCpu};
+  uint32_t m_stopCpu{unknownCpu};
+  uint_fast64_t m_crossCoreSamples{0};
+  crossCorePolicy m_crossCorePolicy{crossCorePolicy::KEEP};
+  latencyHistogram* m_histogram{nullptr};
+  asyncReportSink* m_sink{nullptr};
+  traceWriter* m_trace{nullptr};
+  stageStatistics* m_stages{nullptr};
+  perfCounterGroup* m_counters{nullptr};
+  perfCounterValues m_countersStart{};
+  perfCounterValues m_countersStop{};
+  uint_fast64_t m_budget{UINT_FAST64_MAX};
+  uint_fast64_t m_overBudget{0};
+  budgetCallback m_onOverBudget{};
+  deadlineWatchdog* m_watchdog{nullptr};
+  deadlineWatchdog::slot* m_watchSlot{nullptr};
+  sampleCountdown m_sampling{};
+  bool m_sampledOut{false};
   std::ostream& m_log{std::cout};
 
+  struct lapRecord
+  {
+    timeLabel label {};
+    uint_fast64_t tsc {};
+  };
+
+  std::array<lapRecord, maxLaps> m_laps{};
+  std::size_t m_lapsCount{0};
+  uint_fast64_t m_droppedLaps{0};
+
   void
   setTimerStatus (const rdtscTimerStatus& s) const noexcept
   {
     m_rdtscTimerStatus = s;
   }
+
+  // out of line: only the regions over budget get here
+  void budgetExceeded() noexcept;
+
+  // count a cross-core sample and feed the stopped sample to the histogram
+  // (as the cross-core policy says), to the trace and to the stage
+  // statistics, if any; end the watched run and check the budget
+  void
+  recordSample() noexcept
+  {
+    const bool crossCore {isCrossCore()};
+
+    if ( nullptr != m_watchSlot )
+    {
+      m_watchSlot->end();
+    }
+    if ( (m_stop - m_start) > m_budget )
+    {
+      budgetExceeded();
+    }
+
+    if ( crossCore )
+    {
+      ++m_crossCoreSamples;
+    }
+    if ( (nullptr != m_histogram) &&
+         ((!crossCore) || (crossCorePolicy::KEEP == m_crossCorePolicy)) )
+    {
+      m_histogram->record(m_stop - m_start, m_sampling.getWeight());
+    }
+    if ( nullptr != m_trace )
+    {
+      m_trace->append({m_timerId,
+                       m_startPointLabel.getId(),
+                       m_stopPointLabel.getId(),
+                       toTraceCpu(m_startCpu),
+                       toTraceCpu(m_stopCpu),
+                       m_start,
+                       m_stop,
+                       traceThreadId(),
+                       0});
+    }
+    if ( nullptr != m_stages )
+    {
+      m_stages->record(*this);
+    }
+  }
 };  // class rdtscTimer
 
-// generic lambda (C++14 onwards)
+////////////////////////////////////////////////////////////////////////////////
+// a timer with the API of rdtscTimer whose every member compiles to nothing:
+// it holds no state, reads no clock and writes no report, and its ctor and
+// members take any argument as is, so not even a label is interned
+// (TS_LABEL() still interns its literal once)
+class nullTimer final
+{
+ public:
+  using rdtscTimerStatus = rdtscTimer::rdtscTimerStatus;
+  using crossCorePolicy = rdtscTimer::crossCorePolicy;
+
+  static constexpr std::size_t maxLaps {0};
+
+  template <typename... Args>
+  constexpr
+  explicit nullTimer(Args&&...) noexcept
+  {}
+
+  template <typename readPolicy = defaultReadPolicy, typename... Args>
+  constexpr
+  nullTimer&
+  start(Args&&...) noexcept
+  {
+    return *this;
+  }
+
+  template <typename readPolicy = defaultReadPolicy, typename... Args>
+  constexpr
+  nullTimer&
+  stop(Args&&...) noexcept
+  {
+    return *this;
+  }
+
+  template <typename readPolicy = defaultReadPolicy, typename... Args>
+  constexpr
+  nullTimer&
+  lap(Args&&...) noexcept
+  {
+    return *this;
+  }
+
+  template <typename... Args>
+  constexpr
+  void
+  stopAndReport(Args&&...) noexcept
+  {}
+
+  constexpr
+  nullTimer&
+  report() noexcept
+  {
+    return *this;
+  }
+
+  template <typename... Args>
+  constexpr
+  nullTimer&
+  recordInto(Args&&...) noexcept
+  {
+    return *this;
+  }
+
+  constexpr
+  latencyHistogram*
+  getHistogram() const noexcept
+  {
+    return nullptr;
+  }
+
+  template <typename... Args>
+  constexpr
+  nullTimer&
+  traceTo(Args&&...) noexcept
+  {
+    return *this;
+  }
+
+  constexpr
+  traceWriter*
+  getTrace() const noexcept
+  {
+    return nullptr;
+  }
+
+  template <typename... Args>
+  constexpr
+  nullTimer&
+  reportTo(Args&&...) noexcept
+  {
+    return *this;
+  }
+
+  constexpr
+  asyncReportSink*
+  getReportSink() const noexcept
+  {
+    return nullptr;
+  }
+
+  template <typename... Args>
+  constexpr
+  nullTimer&
+  recordStagesInto(Args&&...) noexcept
+  {
+    return *this;
+  }
+
+  constexpr
+  stageStatistics*
+  getStageStatistics() const noexcept
+  {
+    return nullptr;
+  }
+
+  template <typename... Args>
+  constexpr
+  nullTimer&
+  attachCounters(Args&&...) noexcept
+  {
+    return *this;
+  }
+
+  constexpr
+  perfCounterGroup*
+  getCounters() const noexcept
+  {
+    return nullptr;
+  }
+
+  constexpr
+  perfCounterValues
+  getCountersDelta() const noexcept
+  {
+    return perfCounterValues{};
+  }
+
+  template <typename... Args>
+  constexpr
+  nullTimer&
+  setCrossCorePolicy(Args&&...) noexcept
+  {
+    return *this;
+  }
+
+  constexpr
+  crossCorePolicy
+  getCrossCorePolicy() const noexcept
+  {
+    return crossCorePolicy::KEEP;
+  }
+
+  template <typename... Args>
+  constexpr
+  nullTimer&
+  setBudget(Args&&...) noexcept
+  {
+    return *this;
+  }
+
+  constexpr
+  nullTimer&
+  clearBudget() noexcept
+  {
+    return *this;
+  }
+
+  constexpr
+  uint_fast64_t
+  getBudget() const noexcept
+  {
+    return UINT_FAST64_MAX;
+  }
+
+  template <typename... Args>
+  constexpr
+  nullTimer&
+  watchWith(Args&&...) noexcept
+  {
+    return *this;
+  }
+
+  constexpr
+  deadlineWatchdog*
+  getWatchdog() const noexcept
+  {
+    return nullptr;
+  }
+
+  constexpr
+  uint_fast64_t
+  getOverBudgetCount() const noexcept
+  {
+    return 0;
+  }
+
+  template <typename... Args>
+  constexpr
+  nullTimer&
+  sampleEvery(Args&&...) noexcept
+  {
+    return *this;
+  }
+
+  constexpr
+  uint_fast64_t
+  getSampleWeight() const noexcept
+  {
+    return 1;
+  }
+
+  constexpr
+  bool
+  isSampledOut() const noexcept
+  {
+    return false;
+  }
+
+  template <typename... Args>
+  static
+  constexpr
+  void
+  writeReport(Args&&...) noexcept
+  {}
+
+  static
+  constexpr
+  uint_fast64_t
+  getMeasurementOverhead() noexcept
+  {
+    return 0;
+  }
+
+  template <typename... Args>
+  static
+  constexpr
+  uint_fast64_t
+  calibrateMeasurementOverhead(Args&&...) noexcept
+  {
+    return 0;
+  }
+
+  constexpr
+  const timeLabel&
+  getStartLabel() const noexcept
+  {
+    return m_noLabel;
+  }
+
+  constexpr
+  const timeLabel&
+  getStopLabel() const noexcept
+  {
+    return m_noLabel;
+  }
+
+  constexpr
+  std::size_t
+  getLapsCount() const noexcept
+  {
+    return 0;
+  }
+
+  constexpr
+  const timeLabel&
+  getLapLabel(const std::size_t) const noexcept
+  {
+    return m_noLabel;
+  }
+
+  constexpr
+  uint_fast64_t
+  getLapTSC(const std::size_t) const noexcept
+  {
+    return 0;
+  }
+
+  constexpr
+  uint_fast64_t
+  getLapDeltaTSC(const std::size_t) const noexcept
+  {
+    return 0;
+  }
+
+  constexpr
+  uint_fast64_t
+  getDroppedLaps() const noexcept
+  {
+    return 0;
+  }
+
+  constexpr
+  void
+  writeLaps(std::ostream&) const noexcept
+  {}
+
+  constexpr
+  uint_fast64_t
+  getStartTSC() const noexcept
+  {
+    return 0;
+  }
+
+  constexpr
+  uint_fast64_t
+  getStopTSC() const noexcept
+  {
+    return 0;
+  }
+
+  constexpr
+  uint32_t
+  getStartCpu() const noexcept
+  {
+    return unknownCpu;
+  }
+
+  constexpr
+  uint32_t
+  getStopCpu() const noexcept
+  {
+    return unknownCpu;
+  }
+
+  constexpr
+  bool
+  isCrossCore() const noexcept
+  {
+    return false;
+  }
+
+  constexpr
+  uint_fast64_t
+  getCrossCoreSamples() const noexcept
+  {
+    return 0;
+  }
+
+  constexpr
+  uint_fast64_t
+  getLapsedTSC() const noexcept
+  {
+    return 0;
+  }
+
+  constexpr
+  uint_fast64_t
+  getStopLapsedTSC() const noexcept
+  {
+    return 0;
+  }
+
+  constexpr
+  uint_fast64_t
+  getStopLapsedTSCCorrected() const noexcept
+  {
+    return 0;
+  }
+
+  template <typename... Args>
+  constexpr
+  uint_fast64_t
+  getStopLapsedTSCSkewCorrected(Args&&...) const noexcept
+  {
+    return 0;
+  }
+
+  constexpr
+  uint_fast64_t
+  getStopLapsed_nsecCorrected() const noexcept
+  {
+    return 0;
+  }
+
+  constexpr
+  double
+  getStopLapsed_sec() const noexcept
+  {
+    return 0;
+  }
+
+  constexpr
+  uint_fast64_t
+  getStopLapsed_msec() const noexcept
+  {
+    return 0;
+  }
+
+  constexpr
+  uint_fast64_t
+  getStopLapsed_usec() const noexcept
+  {
+    return 0;
+  }
+
+  constexpr
+  uint_fast64_t
+  getStopLapsed_nsec() const noexcept
+  {
+    return 0;
+  }
+
+  const std::string&
+  getTimerStatusString() const noexcept
+  {
+    return m_inactiveStatus;
+  }
+
+  constexpr
+  rdtscTimerStatus
+  getTimerStatus() const noexcept
+  {
+    return rdtscTimerStatus::INACTIVE;
+  }
+
+  constexpr
+  void
+  operator()() const noexcept
+  {}
+
+  friend
+  constexpr
+  std::ostream&
+  operator<<(std::ostream& os, const nullTimer&) noexcept
+  {
+    return os;
+  }
+
+ private:
+  static constexpr timeLabel m_noLabel{};
+  static const std::string m_inactiveStatus;
+};  // class nullTimer
+
+// the backend policies of timer<>: tscBackend measures with rdtscTimer,
+// nullBackend compiles the instrumentation out with nullTimer
+struct tscBackend
+{
+  using timerType = rdtscTimer;
+};
+
+struct nullBackend
+{
+  using timerType = nullTimer;
+};
+
+// leave the instrumentation in the code and choose its cost at compile time:
+//   using hotPathBackend = std::conditional_t<profiling, tscBackend, nullBackend>;
+//   timer<hotPathBackend> t {"hot path"};
+template <typename backend = tscBackend>
+using timer = typename backend::timerType;
+
+// generic lambda (C++14 onwards)
+// labels are passed by id: use TS_LABEL() at the call site to intern a
+// literal once and never build a string on the hot path
+// works with any timer<>: with a nullTimer only func is left, with an
+// rdtscTimer in sampling mode (sampleEvery()) only the sampled calls are timed
+inline
 decltype(auto)
-profileFunction = [] (rdtscTimer& rdtsct,
-                      const std::string&& startPoint,
-                      const std::string&& stopPoint,
+profileFunction = [] (auto& rdtsct,
+                      auto&& startPoint,
+                      auto&& stopPoint,
                       auto&& func, auto&&... params) noexcept(false) -> void // C++14's universal references aka forwarding references
 {
   // start timer
@@ -0,0 +1,106 @@
+/*
+ * File:   time_zones.cpp
+ * Author: massimo
+ *
+ * Created on October 17, 2026, 4:20 PM
+ */
+#include "time_zones.h"
+#include <algorithm>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+namespace
+{
+// constant initialized: zones created by other static initializers are safe
+std::atomic<zoneDescriptor*> zonesHead {nullptr};
+std::atomic<std::size_t> zonesRegistered {0};
+}  // namespace
+
+zoneDescriptor::zoneDescriptor(const char* name,
+                               const char* file,
+                               const unsigned int line) noexcept
+:
+m_name{name},
+m_file{file},
+m_line{line},
+m_label{internLabel(name)}
+{
+  m_next = zonesHead.load(std::memory_order_relaxed);
+  while ( !zonesHead.compare_exchange_weak(m_next, this,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed) )
+  {
+  }
+  zonesRegistered.fetch_add(1, std::memory_order_relaxed);
+}
+
+zoneStatistics
+zoneDescriptor::snapshot() const
+{
+  zoneStatistics&& z {};
+  uint_fast64_t min {UINT_FAST64_MAX};
+
+  m_shards.forEach([&z, &min] (const shard& s)
+  {
+    z.count += s.count.load(std::memory_order_relaxed);
+    z.sum += s.sum.load(std::memory_order_relaxed);
+    min = std::min(min, s.min.load(std::memory_order_relaxed));
+    z.max = std::max(z.max, s.max.load(std::memory_order_relaxed));
+  });
+  z.min = (0 == z.count) ? 0 : min;
+
+  return z;
+}
+
+const zoneDescriptor*
+firstZone() noexcept
+{
+  return zonesHead.load(std::memory_order_acquire);
+}
+
+std::size_t
+zonesCount() noexcept
+{
+  return zonesRegistered.load(std::memory_order_relaxed);
+}
+
+void
+dumpZones(std::ostream& os)
+{
+  std::vector<std::pair<const zoneDescriptor*, zoneStatistics>> zones {};
+
+  for (const zoneDescriptor* z {firstZone()}; nullptr != z; z = z->getNext())
+  {
+    const zoneStatistics&& s = z->snapshot();
+
+    if ( 0 != s.count )
+    {
+      zones.emplace_back(z, s);
+    }
+  }
+  std::stable_sort(zones.begin(), zones.end(), [] (auto&& a, auto&& b)
+  {
+    return a.second.sum > b.second.sum;
+  });
+
+  for (auto&& z : zones)
+  {
+    const zoneStatistics& s = z.second;
+    const uint_fast64_t mean {static_cast<uint_fast64_t>(s.mean())};
+
+    os << z.first->getName()
+       << " (" << z.first->getFile() << ':' << z.first->getLine() << "): "
+       << s.count << " calls: total " << s.sum
+       << " mean " << mean
+       << " min " << s.min
+       << " max " << s.max
+       << " ticks [ total " << tsc_clock::toNanoseconds(s.sum)
+       << " mean " << tsc_clock::toNanoseconds(mean)
+       << " min " << tsc_clock::toNanoseconds(s.min)
+       << " max " << tsc_clock::toNanoseconds(s.max)
+       << " nsec ]"
+       << '\n';
+  }
+}
+}  // namespace timeSupport
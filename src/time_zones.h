@@ -0,0 +1,209 @@
+/*
+ * File:   time_zones.h
+ * Author: massimo
+ *
+ * Created on October 17, 2026, 4:20 PM
+ */
+#pragma once
+
+#include "labels.h"
+#include "sampling.h"
+#include "thread_shards.h"
+#include "tsc_clock.h"
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+// the merged statistics of a zone
+struct zoneStatistics
+{
+  uint_fast64_t count {};
+  uint_fast64_t sum {};
+  uint_fast64_t min {};
+  uint_fast64_t max {};
+
+  double
+  mean() const noexcept
+  {
+    return (0 == count) ? 0.0 : (static_cast<double>(sum) / static_cast<double>(count));
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// a timed zone: one per call site, created once by TIME_ZONE() as a static
+// the constructor links the zone in the global zone registry, which is a
+// lock-free singly linked list of all the zones ever created; zones are never
+// unlinked, so they must have static storage duration
+// every thread records into its own cache-line-aligned shard of count, sum,
+// min and max with relaxed loads and stores only
+class zoneDescriptor final
+{
+ public:
+  zoneDescriptor(const char* name, const char* file, const unsigned int line) noexcept;
+
+  zoneDescriptor(const zoneDescriptor&) = delete;
+  zoneDescriptor& operator=(const zoneDescriptor&) = delete;
+
+  void
+  record(const uint_fast64_t ticks, const uint_fast64_t n = 1) noexcept
+  {
+    m_shards.local().record(ticks, n);
+  }
+
+  // merge all the threads' shards
+  zoneStatistics snapshot() const;
+
+  const char*
+  getName() const noexcept
+  {
+    return m_name;
+  }
+
+  const char*
+  getFile() const noexcept
+  {
+    return m_file;
+  }
+
+  unsigned int
+  getLine() const noexcept
+  {
+    return m_line;
+  }
+
+  labelId
+  getLabel() const noexcept
+  {
+    return m_label;
+  }
+
+  // the zone registered before this one, nullptr for the first
+  const zoneDescriptor*
+  getNext() const noexcept
+  {
+    return m_next;
+  }
+
+ private:
+  struct alignas(64) shard
+  {
+    std::atomic<uint_fast64_t> count {};
+    std::atomic<uint_fast64_t> sum {};
+    std::atomic<uint_fast64_t> min {UINT_FAST64_MAX};
+    std::atomic<uint_fast64_t> max {};
+
+    // single writer: the owning thread
+    void
+    record(const uint_fast64_t ticks, const uint_fast64_t n) noexcept
+    {
+      count.store(count.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+      sum.store(sum.load(std::memory_order_relaxed) + (ticks * n), std::memory_order_relaxed);
+      if ( ticks < min.load(std::memory_order_relaxed) )
+      {
+        min.store(ticks, std::memory_order_relaxed);
+      }
+      if ( ticks > max.load(std::memory_order_relaxed) )
+      {
+        max.store(ticks, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  const char* const m_name;
+  const char* const m_file;
+  const unsigned int m_line;
+  const labelId m_label;
+  threadShards<shard> m_shards {};
+  zoneDescriptor* m_next {nullptr};
+};  // class zoneDescriptor
+
+////////////////////////////////////////////////////////////////////////////////
+// times the rest of the scope into a zone
+class zoneGuard final
+{
+ public:
+  explicit
+  zoneGuard(zoneDescriptor& zone) noexcept
+  :
+  m_zone(zone),
+  m_start{startTSC()}
+  {}
+
+  ~zoneGuard() noexcept
+  {
+    m_zone.record(stopTSC() - m_start);
+  }
+
+  zoneGuard(const zoneGuard&) = delete;
+  zoneGuard& operator=(const zoneGuard&) = delete;
+
+ private:
+  zoneDescriptor& m_zone;
+  const uint_fast64_t m_start;
+};  // class zoneGuard
+
+// times the rest of the scope into a zone, one execution in the period of
+// the sampler; a timed execution is recorded with the period as weight, so
+// the calls and the total of the zone estimate the ones of all the executions
+class sampledZoneGuard final
+{
+ public:
+  sampledZoneGuard(zoneDescriptor& zone, sampler& s) noexcept
+  :
+  m_zone(zone),
+  m_sampler(s),
+  m_start{m_sampler.take() ? startTSC() : 0}
+  {}
+
+  ~sampledZoneGuard() noexcept
+  {
+    if ( 0 != m_start )
+    {
+      m_zone.record(stopTSC() - m_start, m_sampler.getWeight());
+    }
+  }
+
+  sampledZoneGuard(const sampledZoneGuard&) = delete;
+  sampledZoneGuard& operator=(const sampledZoneGuard&) = delete;
+
+ private:
+  zoneDescriptor& m_zone;
+  sampler& m_sampler;
+  // 0: not timed
+  const uint_fast64_t m_start;
+};  // class sampledZoneGuard
+
+// the most recently registered zone, nullptr when there is none; walk the
+// registry with getNext()
+const zoneDescriptor* firstZone() noexcept;
+
+std::size_t zonesCount() noexcept;
+
+// one line per zone with calls, total, mean, min and max in ticks and nsec,
+// the zones with the largest total first; zones never entered are skipped
+void dumpZones(std::ostream& os = std::cout);
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
+
+#define TS_ZONE_CONCAT_(a, b) a##b
+#define TS_ZONE_CONCAT(a, b) TS_ZONE_CONCAT_(a, b)
+
+// time the rest of the enclosing scope as the zone named name (a literal)
+// the zone is created and registered the first time the line is executed
+#define TIME_ZONE(name)                                                          \
+  static ::timeSupport::zoneDescriptor TS_ZONE_CONCAT(tsZone_, __LINE__)         \
+    {name, __FILE__, __LINE__};                                                  \
+  const ::timeSupport::zoneGuard TS_ZONE_CONCAT(tsZoneGuard_, __LINE__)          \
+    {TS_ZONE_CONCAT(tsZone_, __LINE__)}
+
+// TIME_ZONE() timing one execution in period, at random gaps of mean period
+// on each thread
+#define TIME_ZONE_SAMPLED(name, period)                                          \
+  static ::timeSupport::zoneDescriptor TS_ZONE_CONCAT(tsZone_, __LINE__)         \
+    {name, __FILE__, __LINE__};                                                  \
+  static ::timeSupport::sampler TS_ZONE_CONCAT(tsZoneSampler_, __LINE__)         \
+    {period, ::timeSupport::samplingMode::GEOMETRIC};                            \
+  const ::timeSupport::sampledZoneGuard TS_ZONE_CONCAT(tsZoneGuard_, __LINE__)   \
+    {TS_ZONE_CONCAT(tsZone_, __LINE__), TS_ZONE_CONCAT(tsZoneSampler_, __LINE__)}
@@ -0,0 +1,90 @@
+/*
+ * File:   timer_registry.cpp
+ * Author: massimo
+ *
+ * Created on October 20, 2026, 3:30 PM
+ */
+// BEGIN: ignore the warnings listed below when compiled with clang from here
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+////////////////////////////////////////////////////////////////////////////////
+#include "timer_registry.h"
+#include <algorithm>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+sharedTimer::sharedTimer(const std::string& name)
+:
+m_name{name},
+m_histogram{name},
+m_timers{[this] () { return std::make_unique<shard>(m_name, m_histogram); }}
+{}
+
+timerRegistry&
+timerRegistry::global()
+{
+  static timerRegistry registry {};
+
+  return registry;
+}
+
+sharedTimer&
+timerRegistry::get(const std::string& name)
+{
+  std::lock_guard<std::mutex> lock {m_mutex};
+  auto&& t = m_timers[name];
+
+  if ( nullptr == t )
+  {
+    t = std::make_unique<sharedTimer>(name);
+  }
+  return *t;
+}
+
+const sharedTimer*
+timerRegistry::find(const std::string& name) const
+{
+  std::lock_guard<std::mutex> lock {m_mutex};
+  auto&& it = m_timers.find(name);
+
+  return (m_timers.end() == it) ? nullptr : it->second.get();
+}
+
+std::size_t
+timerRegistry::size() const
+{
+  std::lock_guard<std::mutex> lock {m_mutex};
+
+  return m_timers.size();
+}
+
+std::vector<const sharedTimer*>
+timerRegistry::sortedTimers() const
+{
+  std::vector<const sharedTimer*> timers {};
+
+  timers.reserve(m_timers.size());
+  for (auto&& t : m_timers)
+  {
+    timers.push_back(t.second.get());
+  }
+  std::sort(timers.begin(), timers.end(), [] (const sharedTimer* a, const sharedTimer* b)
+  {
+    return a->getName() < b->getName();
+  });
+
+  return timers;
+}
+
+void
+timerRegistry::report(std::ostream& os) const
+{
+  forEach([&os] (const sharedTimer& t)
+  {
+    t.report(os);
+  });
+}
+}  // namespace timeSupport
+////////////////////////////////////////////////////////////////////////////////
+#pragma clang diagnostic pop
+// END: ignore the warnings when compiled with clang up to here
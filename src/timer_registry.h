@@ -0,0 +1,142 @@
+/*
+ * File:   timer_registry.h
+ * Author: massimo
+ *
+ * Created on October 20, 2026, 3:30 PM
+ */
+#pragma once
+
+#include "time_support.h"
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+// a named timer shared by many threads
+// an rdtscTimer is not thread safe: here every thread gets its own timer, in
+// its own cache-line-aligned shard, recording into a latencyHistogram shared
+// by all the threads (sharded in turn), so that threads timing the same
+// operation neither lock nor contend nor share cache lines
+class sharedTimer final
+{
+ public:
+  explicit sharedTimer(const std::string& name);
+
+  sharedTimer(const sharedTimer&) = delete;
+  sharedTimer& operator=(const sharedTimer&) = delete;
+
+  // the calling thread's timer, in histogram mode: its stop() records the
+  // sample and its report() writes nothing
+  rdtscTimer&
+  local()
+  {
+    return m_timers.local().timer;
+  }
+
+  // add a sample measured elsewhere
+  void
+  record(const uint_fast64_t ticks) noexcept
+  {
+    m_histogram.record(ticks);
+  }
+
+  // merge all the threads' samples
+  tickHistogram
+  snapshot() const
+  {
+    return m_histogram.snapshot();
+  }
+
+  // the number of threads that used the timer
+  std::size_t
+  getThreadsCount() const
+  {
+    return m_timers.size();
+  }
+
+  void
+  report(std::ostream& os = std::cout) const
+  {
+    m_histogram.report(os);
+  }
+
+  const std::string&
+  getName() const noexcept
+  {
+    return m_name;
+  }
+
+ private:
+  struct alignas(64) shard
+  {
+    shard(const std::string& name, latencyHistogram& histogram)
+    :
+    timer{name}
+    {
+      timer.recordInto(&histogram);
+    }
+
+    rdtscTimer timer;
+  };
+
+  const std::string m_name {};
+  // declared before the timers: a timer left started records at destruction
+  latencyHistogram m_histogram;
+  threadShards<shard> m_timers;
+};  // class sharedTimer
+
+////////////////////////////////////////////////////////////////////////////////
+// the named shared timers of a process
+// get() locks: look a timer up once and keep the reference, e.g.
+//   static sharedTimer& t {timerRegistry::global().get("db.query")};
+//   t.local().start(TS_LABEL("QUERY"));
+// timers are never removed, so references stay valid while the registry lives
+class timerRegistry final
+{
+ public:
+  timerRegistry() = default;
+
+  timerRegistry(const timerRegistry&) = delete;
+  timerRegistry& operator=(const timerRegistry&) = delete;
+
+  // the registry of the process
+  static timerRegistry& global();
+
+  // the timer called name, created on the first call
+  sharedTimer& get(const std::string& name);
+
+  // nullptr when there is no timer called name
+  const sharedTimer* find(const std::string& name) const;
+
+  std::size_t size() const;
+
+  // visit the timers sorted by name
+  template <typename F>
+  void
+  forEach(F&& f) const
+  {
+    std::lock_guard<std::mutex> lock {m_mutex};
+
+    for (auto&& t : sortedTimers())
+    {
+      f(*t);
+    }
+  }
+
+  // one line per timer, sorted by name: the merged percentiles of the samples
+  // of all the threads
+  void report(std::ostream& os = std::cout) const;
+
+ private:
+  mutable std::mutex m_mutex {};
+  std::unordered_map<std::string, std::unique_ptr<sharedTimer>> m_timers {};
+
+  // with m_mutex held
+  std::vector<const sharedTimer*> sortedTimers() const;
+};  // class timerRegistry
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
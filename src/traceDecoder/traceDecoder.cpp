@@ -0,0 +1,94 @@
+//
+//  traceDecoder.cpp
+//
+//  decode a binary trace written by timeSupport::traceWriter
+//
+#include "../binary_trace.h"
+
+#include <cstring>
+#include <iostream>
+////////////////////////////////////////////////////////////////////////////////
+enum class outputFormat { STATS, CSV, CHROME };
+
+static
+void
+usage(const char* program) noexcept
+{
+  std::cerr << "usage: "
+            << program
+            << " [--stats [--drop-cross-core] | --csv | --chrome] <trace-file>"
+            << '\n'
+            << "  --stats            per timer and start/stop label pair statistics (default)"
+            << '\n'
+            << "  --drop-cross-core  leave the records started and stopped on different CPUs out of the statistics"
+            << '\n'
+            << "  --csv              one CSV line per record"
+            << '\n'
+            << "  --chrome           Chrome Trace Event JSON, for Perfetto or chrome://tracing"
+            << '\n';
+}
+
+int
+main(int argc, char* argv[])
+{
+  outputFormat format {outputFormat::STATS};
+  bool keepCrossCore {true};
+  const char* fileName {nullptr};
+
+  for (int&& i {1}; i < argc; ++i)
+  {
+    if ( 0 == std::strcmp(argv[i], "--csv") )
+    {
+      format = outputFormat::CSV;
+    }
+    else if ( 0 == std::strcmp(argv[i], "--chrome") )
+    {
+      format = outputFormat::CHROME;
+    }
+    else if ( 0 == std::strcmp(argv[i], "--stats") )
+    {
+      format = outputFormat::STATS;
+    }
+    else if ( 0 == std::strcmp(argv[i], "--drop-cross-core") )
+    {
+      keepCrossCore = false;
+    }
+    else if ( (nullptr == fileName) && ('-' != argv[i][0]) )
+    {
+      fileName = argv[i];
+    }
+    else
+    {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if ( nullptr == fileName )
+  {
+    usage(argv[0]);
+    return 2;
+  }
+
+  const timeSupport::traceReader trace {fileName};
+
+  if ( !trace.isValid() )
+  {
+    std::cerr << "ERROR: " << trace.getError() << '\n';
+    return 1;
+  }
+
+  switch ( format )
+  {
+    case outputFormat::CSV:
+      timeSupport::writeTraceCSV(trace, std::cout);
+      break;
+    case outputFormat::CHROME:
+      timeSupport::writeTraceChromeJSON(trace, std::cout);
+      break;
+    case outputFormat::STATS:
+      timeSupport::writeTraceStatistics(trace, std::cout, keepCrossCore);
+      break;
+  }
+
+  return 0;
+}
@@ -0,0 +1,59 @@
+//
+//  tscSkew.cpp
+//
+//  measure the TSC offsets and the cache line round trips of every pair of
+//  the CPUs this process may run on
+//
+#include "../tsc_skew.h"
+#include "../clock_backend.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+////////////////////////////////////////////////////////////////////////////////
+static
+void
+usage(const char* program) noexcept
+{
+  std::cerr << "usage: "
+            << program
+            << " [--rounds <n>]"
+            << '\n'
+            << "  --rounds <n>  ping-pong rounds per CPU pair (default 10000)"
+            << '\n'
+            << "run it under taskset to measure a subset of the CPUs"
+            << '\n';
+}
+
+int
+main(int argc, char* argv[])
+{
+  unsigned int rounds {10'000};
+
+  for (int&& i {1}; i < argc; ++i)
+  {
+    if ( (0 == std::strcmp(argv[i], "--rounds")) && ((i + 1) < argc) )
+    {
+      rounds = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+    }
+    else
+    {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if ( 0 == rounds )
+  {
+    usage(argv[0]);
+    return 2;
+  }
+
+  timeSupport::writeClockSupport(std::cout);
+
+  const std::vector<uint32_t>&& cpus = timeSupport::allowedCpus();
+
+  std::cout << cpus.size() << " CPUs, " << rounds << " rounds per pair" << '\n';
+  std::cout << timeSupport::measureTscSkewMatrix(cpus, rounds);
+
+  return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * File:   tsc_clock.cpp
+ * Author: massimo
+ *
+ * Created on October 16, 2026, 9:10 AM
+ */
+// BEGIN: ignore the warnings listed below when compiled with clang from here
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wexit-time-destructors"
+#pragma clang diagnostic ignored "-Wglobal-constructors"
+////////////////////////////////////////////////////////////////////////////////
+#include "tsc_clock.h"
+#include <cerrno>
+#include <ctime>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+namespace
+{
+constexpr uint_fast32_t calibrationShift {32};
+constexpr int bracketAttempts {8};
+
+struct referencePoint
+{
+  uint_fast64_t tsc {};
+  uint_fast64_t nsec {};
+};
+
+// ticks already in nanoseconds
+tscCalibration
+identityCalibration() noexcept
+{
+  tscCalibration&& c {};
+
+  c.tscHz = 1'000'000'000;
+  c.mult = uint_fast64_t{1} << calibrationShift;
+  c.shift = calibrationShift;
+
+  return c;
+}
+
+// read CLOCK_MONOTONIC_RAW between two TSC reads and keep the
+// narrowest bracket, so the TSC value is the best match for the time read
+referencePoint
+takeReferencePoint() noexcept
+{
+  referencePoint&& best {};
+  uint_fast64_t bestWidth {UINT_FAST64_MAX};
+
+  for (int&& i {0}; i < bracketAttempts; ++i)
+  {
+    auto&& before = rdtscp();
+    auto&& nsec = monotonicRawTicks();
+    auto&& after = rdtscp();
+
+    if ( (after - before) < bestWidth )
+    {
+      bestWidth = after - before;
+      best.tsc = before + ((after - before) / 2);
+      best.nsec = nsec;
+    }
+  }
+  return best;
+}
+
+// take the measure when the process starts, not in the first timed region
+[[maybe_unused]]
+const tscCalibration& startupCalibration = tsc_clock::calibration();
+}  // namespace
+
+tscCalibration
+calibrateTSC(const std::chrono::nanoseconds& window) noexcept
+{
+  auto&& begin = takeReferencePoint();
+
+  timespec&& req {static_cast<time_t>(window.count() / 1'000'000'000),
+                  static_cast<long>(window.count() % 1'000'000'000)};
+  timespec&& rem {};
+
+  while ( (0 != nanosleep(&req, &rem)) && (EINTR == errno) )
+  {
+    // retry, with the provided time remaining
+    req = rem;
+  }
+
+  auto&& end = takeReferencePoint();
+
+  const uint_fast64_t ticks {end.tsc - begin.tsc};
+  const uint_fast64_t nsec {end.nsec - begin.nsec};
+  tscCalibration&& c {};
+
+  if ( (0 == ticks) || (0 == nsec) )
+  {
+    // no usable measure: keep the conversion as the identity
+    return identityCalibration();
+  }
+
+  c.tscHz = static_cast<uint_fast64_t>((static_cast<double>(ticks) * 1e9) / static_cast<double>(nsec));
+  c.mult = ((nsec << calibrationShift) + (ticks / 2)) / ticks;
+  c.shift = calibrationShift;
+
+  return c;
+}
+
+const tscCalibration&
+tsc_clock::calibration() noexcept
+{
+  static const tscCalibration identity {identityCalibration()};
+
+  // the TSC is never read, not even to calibrate it, with the fallback
+  if ( !usingTSC() )
+  {
+    return identity;
+  }
+
+  static const tscCalibration c {calibrateTSC()};
+
+  return c;
+}
+}  // namespace timeSupport
+////////////////////////////////////////////////////////////////////////////////
+#pragma clang diagnostic pop
+// END: ignore the warnings when compiled with clang up to here
@@ -0,0 +1,356 @@
+/*
+ * File:   tsc_clock.h
+ * Author: massimo
+ *
+ * Created on October 16, 2026, 9:10 AM
+ */
+#pragma once
+
+#include "clock_backend.h"
+#include <chrono>
+#include <cstdint>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+inline
+uint_fast64_t
+rdtscp() noexcept
+{
+  volatile uint_fast32_t tickl {};
+  volatile uint_fast32_t tickh {};
+
+  __asm__ __volatile__("rdtscp" : "=a"(tickl), "=d"(tickh) :: "%ecx");
+
+  return ((static_cast<uint_fast64_t>(tickh) << 32) | tickl);
+}
+
+inline
+void
+rdtscp(uint_fast64_t& r) noexcept
+{
+  volatile uint_fast32_t tickl {};
+  volatile uint_fast32_t tickh {};
+
+  __asm__ __volatile__("rdtscp" : "=a"(tickl), "=d"(tickh) :: "%ecx");
+
+  r = (static_cast<uint_fast64_t>(tickh) << 32) | tickl;
+}
+
+// not ordered at all: the read can move before and after its neighbours
+inline
+uint_fast64_t
+rdtsc() noexcept
+{
+  volatile uint_fast32_t tickl {};
+  volatile uint_fast32_t tickh {};
+
+  __asm__ __volatile__("rdtsc" : "=a"(tickl), "=d"(tickh));
+
+  return ((static_cast<uint_fast64_t>(tickh) << 32) | tickl);
+}
+
+// the read waits for the previous instructions to complete
+inline
+uint_fast64_t
+lfenceRdtsc() noexcept
+{
+  volatile uint_fast32_t tickl {};
+  volatile uint_fast32_t tickh {};
+
+  __asm__ __volatile__("lfence\n\t"
+                       "rdtsc" : "=a"(tickl), "=d"(tickh) :: "memory");
+
+  return ((static_cast<uint_fast64_t>(tickh) << 32) | tickl);
+}
+
+// the read waits for the previous instructions and the following ones
+// wait for the read
+inline
+uint_fast64_t
+rdtscpLfence() noexcept
+{
+  volatile uint_fast32_t tickl {};
+  volatile uint_fast32_t tickh {};
+
+  __asm__ __volatile__("rdtscp\n\t"
+                       "lfence" : "=a"(tickl), "=d"(tickh) :: "%ecx", "memory");
+
+  return ((static_cast<uint_fast64_t>(tickh) << 32) | tickl);
+}
+
+// fully serialized start read: cpuid drains the pipeline before rdtsc
+inline
+uint_fast64_t
+cpuidRdtsc() noexcept
+{
+  volatile uint_fast32_t tickl {};
+  volatile uint_fast32_t tickh {};
+
+  __asm__ __volatile__("cpuid\n\t"
+                       "rdtsc" : "=a"(tickl), "=d"(tickh) : "a"(0) : "%ebx", "%ecx", "memory");
+
+  return ((static_cast<uint_fast64_t>(tickh) << 32) | tickl);
+}
+
+// fully serialized stop read: nothing after cpuid starts before the read
+inline
+uint_fast64_t
+rdtscpCpuid() noexcept
+{
+  volatile uint_fast32_t tickl {};
+  volatile uint_fast32_t tickh {};
+
+  __asm__ __volatile__("rdtscp\n\t"
+                       "mov %%eax, %k0\n\t"
+                       "mov %%edx, %k1\n\t"
+                       "cpuid" : "=r"(tickl), "=r"(tickh) :: "%eax", "%ebx", "%ecx", "%edx", "memory");
+
+  return ((static_cast<uint_fast64_t>(tickh) << 32) | tickl);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// rdtscp also loads TSC_AUX in ecx: Linux sets it to (numa node << 12) | cpu
+// so the CPU that read the counter comes for free with the ticks; the reads
+// below return it in cpu, unknownCpu for the reads not using rdtscp
+constexpr uint32_t unknownCpu {UINT32_MAX};
+
+constexpr
+uint32_t
+tscAuxToCpu(const uint32_t aux) noexcept
+{
+  return aux & 0xfff;
+}
+
+inline
+uint_fast64_t
+rdtscp(uint32_t& cpu) noexcept
+{
+  volatile uint_fast32_t tickl {};
+  volatile uint_fast32_t tickh {};
+  volatile uint32_t aux {};
+
+  __asm__ __volatile__("rdtscp" : "=a"(tickl), "=d"(tickh), "=c"(aux));
+
+  cpu = tscAuxToCpu(aux);
+
+  return ((static_cast<uint_fast64_t>(tickh) << 32) | tickl);
+}
+
+inline
+uint_fast64_t
+rdtscpLfence(uint32_t& cpu) noexcept
+{
+  volatile uint_fast32_t tickl {};
+  volatile uint_fast32_t tickh {};
+  volatile uint32_t aux {};
+
+  __asm__ __volatile__("rdtscp\n\t"
+                       "lfence" : "=a"(tickl), "=d"(tickh), "=c"(aux) :: "memory");
+
+  cpu = tscAuxToCpu(aux);
+
+  return ((static_cast<uint_fast64_t>(tickh) << 32) | tickl);
+}
+
+inline
+uint_fast64_t
+rdtscpCpuid(uint32_t& cpu) noexcept
+{
+  volatile uint_fast32_t tickl {};
+  volatile uint_fast32_t tickh {};
+  volatile uint32_t aux {};
+
+  __asm__ __volatile__("rdtscp\n\t"
+                       "mov %%eax, %k0\n\t"
+                       "mov %%edx, %k1\n\t"
+                       "mov %%ecx, %k2\n\t"
+                       "cpuid" : "=r"(tickl), "=r"(tickh), "=r"(aux) :: "%eax", "%ebx", "%ecx", "%edx", "memory");
+
+  cpu = tscAuxToCpu(aux);
+
+  return ((static_cast<uint_fast64_t>(tickh) << 32) | tickl);
+}
+
+// the fallback read does not know its CPU
+inline
+uint_fast64_t
+monotonicRawTicks(uint32_t& cpu) noexcept
+{
+  cpu = unknownCpu;
+
+  return monotonicRawTicks();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// TSC read policies: how the start and the stop reads of a timed region are
+// fenced; a stronger fence keeps the region's instructions between the reads
+// at the cost of a longer and more variable read
+//   tscRdtsc            rdtsc / rdtsc                cheapest, no ordering
+//   tscLfenceRdtsc      lfence;rdtsc / lfence;rdtsc
+//   tscRdtscp           rdtscp / rdtscp              the default
+//   tscRdtscpLfence     rdtscp;lfence / rdtscp;lfence
+//   tscCpuidSerialized  cpuid;rdtsc / rdtscp;cpuid   most precise, slowest
+// the overloads taking cpu also return the CPU id of the read
+// with the MONOTONIC_RAW backend (see clock_backend.h) every policy reads
+// clock_gettime() instead
+struct tscRdtsc
+{
+  static uint_fast64_t start() noexcept { return usingTSC() ? rdtsc() : monotonicRawTicks(); }
+  static uint_fast64_t stop() noexcept { return usingTSC() ? rdtsc() : monotonicRawTicks(); }
+  static uint_fast64_t start(uint32_t& cpu) noexcept { cpu = unknownCpu; return start(); }
+  static uint_fast64_t stop(uint32_t& cpu) noexcept { cpu = unknownCpu; return stop(); }
+};
+
+struct tscLfenceRdtsc
+{
+  static uint_fast64_t start() noexcept { return usingTSC() ? lfenceRdtsc() : monotonicRawTicks(); }
+  static uint_fast64_t stop() noexcept { return usingTSC() ? lfenceRdtsc() : monotonicRawTicks(); }
+  static uint_fast64_t start(uint32_t& cpu) noexcept { cpu = unknownCpu; return start(); }
+  static uint_fast64_t stop(uint32_t& cpu) noexcept { cpu = unknownCpu; return stop(); }
+};
+
+struct tscRdtscp
+{
+  static uint_fast64_t start() noexcept { return usingTSC() ? rdtscp() : monotonicRawTicks(); }
+  static uint_fast64_t stop() noexcept { return usingTSC() ? rdtscp() : monotonicRawTicks(); }
+  static uint_fast64_t start(uint32_t& cpu) noexcept { return usingTSC() ? rdtscp(cpu) : monotonicRawTicks(cpu); }
+  static uint_fast64_t stop(uint32_t& cpu) noexcept { return usingTSC() ? rdtscp(cpu) : monotonicRawTicks(cpu); }
+};
+
+struct tscRdtscpLfence
+{
+  static uint_fast64_t start() noexcept { return usingTSC() ? rdtscpLfence() : monotonicRawTicks(); }
+  static uint_fast64_t stop() noexcept { return usingTSC() ? rdtscpLfence() : monotonicRawTicks(); }
+  static uint_fast64_t start(uint32_t& cpu) noexcept { return usingTSC() ? rdtscpLfence(cpu) : monotonicRawTicks(cpu); }
+  static uint_fast64_t stop(uint32_t& cpu) noexcept { return usingTSC() ? rdtscpLfence(cpu) : monotonicRawTicks(cpu); }
+};
+
+struct tscCpuidSerialized
+{
+  static uint_fast64_t start() noexcept { return usingTSC() ? cpuidRdtsc() : monotonicRawTicks(); }
+  static uint_fast64_t stop() noexcept { return usingTSC() ? rdtscpCpuid() : monotonicRawTicks(); }
+  static uint_fast64_t start(uint32_t& cpu) noexcept { cpu = unknownCpu; return start(); }
+  static uint_fast64_t stop(uint32_t& cpu) noexcept { return usingTSC() ? rdtscpCpuid(cpu) : monotonicRawTicks(cpu); }
+};
+
+using defaultReadPolicy = tscRdtscp;
+
+// read the TSC at the start or at the stop of a region with the given policy
+template <typename readPolicy = defaultReadPolicy>
+inline
+uint_fast64_t
+startTSC() noexcept
+{
+  return readPolicy::start();
+}
+
+template <typename readPolicy = defaultReadPolicy>
+inline
+uint_fast64_t
+stopTSC() noexcept
+{
+  return readPolicy::stop();
+}
+
+template <typename readPolicy = defaultReadPolicy>
+inline
+uint_fast64_t
+startTSC(uint32_t& cpu) noexcept
+{
+  return readPolicy::start(cpu);
+}
+
+template <typename readPolicy = defaultReadPolicy>
+inline
+uint_fast64_t
+stopTSC(uint32_t& cpu) noexcept
+{
+  return readPolicy::stop(cpu);
+}
+
+// TSC frequency measured against CLOCK_MONOTONIC_RAW
+// ticks are converted to nanoseconds as: nsec = (ticks * mult) >> shift
+struct tscCalibration
+{
+  uint_fast64_t tscHz {};
+  uint_fast64_t mult {};
+  uint_fast32_t shift {};
+};
+
+inline
+uint_fast64_t
+ticksToNanoseconds(const uint_fast64_t ticks, const tscCalibration& c) noexcept
+{
+  __extension__ using uint128 = unsigned __int128;
+
+  return static_cast<uint_fast64_t>((static_cast<uint128>(ticks) * c.mult) >> c.shift);
+}
+
+// calibrate the TSC over the given time window; the window must be
+// shorter than ~4 seconds for the fixed-point multiplier to fit
+tscCalibration
+calibrateTSC(const std::chrono::nanoseconds& window = std::chrono::milliseconds(25)) noexcept;
+
+////////////////////////////////////////////////////////////////////////////////
+// a std::chrono Clock reading the TSC
+// the calibration is measured once at startup; time points count the
+// nanoseconds elapsed since the TSC was reset
+// with the MONOTONIC_RAW backend the calibration is the identity and time
+// points are the ones of CLOCK_MONOTONIC_RAW
+class tsc_clock final
+{
+ public:
+  using rep = int64_t;
+  using period = std::nano;
+  using duration = std::chrono::duration<rep, period>;
+  using time_point = std::chrono::time_point<tsc_clock>;
+
+  static constexpr bool is_steady {true};
+
+  static
+  time_point
+  now() noexcept
+  {
+    return time_point(toDuration(stopTSC()));
+  }
+
+  static
+  uint_fast64_t
+  toNanoseconds(const uint_fast64_t ticks) noexcept
+  {
+    return ticksToNanoseconds(ticks, calibration());
+  }
+
+  static
+  duration
+  toDuration(const uint_fast64_t ticks) noexcept
+  {
+    return duration(static_cast<rep>(toNanoseconds(ticks)));
+  }
+
+  static
+  time_point
+  fromTicks(const uint_fast64_t ticks) noexcept
+  {
+    return time_point(toDuration(ticks));
+  }
+
+  // the ticks of a duration, e.g. the budget of a region:
+  //   t.setBudget(tsc_clock::toTicks(std::chrono::microseconds(500)));
+  static
+  uint_fast64_t
+  toTicks(const std::chrono::nanoseconds& d) noexcept
+  {
+    __extension__ using uint128 = unsigned __int128;
+
+    if ( d.count() <= 0 )
+    {
+      return 0;
+    }
+    return static_cast<uint_fast64_t>((static_cast<uint128>(d.count()) * calibration().tscHz) / 1'000'000'000);
+  }
+
+  static const tscCalibration& calibration() noexcept;
+};  // class tsc_clock
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
@@ -0,0 +1,264 @@
+/*
+ * File:   tsc_skew.cpp
+ * Author: massimo
+ *
+ * Created on October 22, 2026, 10:05 AM
+ */
+#include "tsc_skew.h"
+#include "tsc_clock.h"
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <thread>
+#include <sched.h>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+namespace
+{
+// the bounced cache line: an odd seq is a request, an even one a reply
+struct alignas(64) pingPongLine
+{
+  std::atomic<uint64_t> seq {0};
+  std::atomic<uint64_t> tsc {0};
+};
+
+bool
+pinTo(const uint32_t cpu) noexcept
+{
+  if ( cpu >= CPU_SETSIZE )
+  {
+    return false;
+  }
+
+  cpu_set_t set {};
+
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+
+  return 0 == sched_setaffinity(0, sizeof(set), &set);
+}
+
+// spin, then yield: the two threads may share a CPU
+template <typename F>
+void
+spinUntil(F&& done) noexcept
+{
+  for (unsigned int&& spins {0}; !done(); ++spins)
+  {
+    if ( spins < 1'000 )
+    {
+      __builtin_ia32_pause();
+    }
+    else
+    {
+      std::this_thread::yield();
+    }
+  }
+}
+}  // namespace
+
+tscSkewSample
+measureTscSkew(const uint32_t cpuA, const uint32_t cpuB, const unsigned int rounds)
+{
+  pingPongLine line {};
+  std::atomic<int> ready {0};
+  std::atomic<bool> pinned {true};
+  tscSkewSample&& best {};
+
+  // there is no TSC to compare when the timers read another clock
+  if ( !usingTSC() )
+  {
+    return best;
+  }
+
+  auto&& waitForBoth = [&ready, &pinned] (const uint32_t cpu)
+  {
+    if ( !pinTo(cpu) )
+    {
+      pinned.store(false, std::memory_order_relaxed);
+    }
+    ready.fetch_add(1, std::memory_order_acq_rel);
+    spinUntil([&ready] () { return 2 == ready.load(std::memory_order_acquire); });
+
+    return pinned.load(std::memory_order_relaxed);
+  };
+
+  std::thread first([&] ()
+  {
+    if ( !waitForBoth(cpuA) )
+    {
+      return;
+    }
+    best.roundTrip = UINT_FAST64_MAX;
+    for (uint64_t&& i {0}; i < rounds; ++i)
+    {
+      const uint64_t request {(2 * i) + 1};
+      const uint_fast64_t t0 {stopTSC()};
+
+      line.seq.store(request, std::memory_order_release);
+      spinUntil([&line, request] () { return (request + 1) == line.seq.load(std::memory_order_acquire); });
+
+      const uint_fast64_t t1 {stopTSC()};
+      const uint64_t tB {line.tsc.load(std::memory_order_relaxed)};
+
+      if ( (t1 - t0) < best.roundTrip )
+      {
+        best.roundTrip = t1 - t0;
+        best.offset = static_cast<int64_t>(tB - (t0 + ((t1 - t0) / 2)));
+      }
+    }
+    best.valid = true;
+  });
+  std::thread second([&] ()
+  {
+    if ( !waitForBoth(cpuB) )
+    {
+      return;
+    }
+    for (uint64_t&& i {0}; i < rounds; ++i)
+    {
+      const uint64_t request {(2 * i) + 1};
+
+      spinUntil([&line, request] () { return request == line.seq.load(std::memory_order_acquire); });
+      line.tsc.store(stopTSC(), std::memory_order_relaxed);
+      line.seq.store(request + 1, std::memory_order_release);
+    }
+  });
+
+  first.join();
+  second.join();
+
+  return best;
+}
+
+std::vector<uint32_t>
+allowedCpus()
+{
+  std::vector<uint32_t> cpus {};
+  cpu_set_t set {};
+
+  if ( 0 != sched_getaffinity(0, sizeof(set), &set) )
+  {
+    return cpus;
+  }
+  for (uint32_t&& cpu {0}; cpu < CPU_SETSIZE; ++cpu)
+  {
+    if ( CPU_ISSET(cpu, &set) )
+    {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+tscSkewMatrix::tscSkewMatrix(const std::vector<uint32_t>& cpus)
+:
+m_cpus{cpus},
+m_offsets(cpus.size() * cpus.size(), 0),
+m_roundTrips(cpus.size() * cpus.size(), 0)
+{}
+
+std::size_t
+tscSkewMatrix::indexOf(const uint32_t cpu) const noexcept
+{
+  return static_cast<std::size_t>(std::find(m_cpus.begin(), m_cpus.end(), cpu) - m_cpus.begin());
+}
+
+bool
+tscSkewMatrix::has(const uint32_t cpu) const noexcept
+{
+  return indexOf(cpu) < m_cpus.size();
+}
+
+void
+tscSkewMatrix::set(const uint32_t fromCpu, const uint32_t toCpu, const tscSkewSample& s) noexcept
+{
+  const std::size_t from {indexOf(fromCpu)};
+  const std::size_t to {indexOf(toCpu)};
+  const std::size_t n {m_cpus.size()};
+
+  if ( (from >= n) || (to >= n) || (!s.valid) )
+  {
+    return;
+  }
+  m_offsets[(from * n) + to] = s.offset;
+  m_offsets[(to * n) + from] = -s.offset;
+  m_roundTrips[(from * n) + to] = s.roundTrip;
+  m_roundTrips[(to * n) + from] = s.roundTrip;
+}
+
+int64_t
+tscSkewMatrix::offset(const uint32_t fromCpu, const uint32_t toCpu) const noexcept
+{
+  const std::size_t from {indexOf(fromCpu)};
+  const std::size_t to {indexOf(toCpu)};
+  const std::size_t n {m_cpus.size()};
+
+  return ((from >= n) || (to >= n)) ? 0 : m_offsets[(from * n) + to];
+}
+
+uint_fast64_t
+tscSkewMatrix::roundTrip(const uint32_t fromCpu, const uint32_t toCpu) const noexcept
+{
+  const std::size_t from {indexOf(fromCpu)};
+  const std::size_t to {indexOf(toCpu)};
+  const std::size_t n {m_cpus.size()};
+
+  return ((from >= n) || (to >= n)) ? 0 : m_roundTrips[(from * n) + to];
+}
+
+std::ostream& operator<<(std::ostream& os, const tscSkewMatrix& obj)
+{
+  auto&& writeMatrix = [&os, &obj] (const char* title, auto&& value)
+  {
+    os << title << '\n' << std::setw(8) << "cpu";
+    for (auto&& to : obj.m_cpus)
+    {
+      os << std::setw(10) << to;
+    }
+    os << '\n';
+    for (auto&& from : obj.m_cpus)
+    {
+      os << std::setw(8) << from;
+      for (auto&& to : obj.m_cpus)
+      {
+        os << std::setw(10) << value(from, to);
+      }
+      os << '\n';
+    }
+  };
+
+  writeMatrix("TSC offset (ticks, column cpu - row cpu):", [&obj] (const uint32_t from, const uint32_t to)
+  {
+    return obj.offset(from, to);
+  });
+  writeMatrix("round trip (ticks):", [&obj] (const uint32_t from, const uint32_t to)
+  {
+    return obj.roundTrip(from, to);
+  });
+
+  return os;
+}
+
+tscSkewMatrix
+measureTscSkewMatrix(const std::vector<uint32_t>& cpus, const unsigned int rounds)
+{
+  if ( !usingTSC() )
+  {
+    return tscSkewMatrix{};
+  }
+
+  tscSkewMatrix m {cpus};
+
+  for (std::size_t&& i {0}; i < cpus.size(); ++i)
+  {
+    for (std::size_t&& j {i + 1}; j < cpus.size(); ++j)
+    {
+      m.set(cpus[i], cpus[j], measureTscSkew(cpus[i], cpus[j], rounds));
+    }
+  }
+  return m;
+}
+}  // namespace timeSupport
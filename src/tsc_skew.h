@@ -0,0 +1,94 @@
+/*
+ * File:   tsc_skew.h
+ * Author: massimo
+ *
+ * Created on October 22, 2026, 10:05 AM
+ */
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+////////////////////////////////////////////////////////////////////////////////
+namespace timeSupport
+{
+// the offset of the TSC of a CPU to the TSC of another one, measured by a
+// thread pinned to each CPU bouncing a cache line: the first one reads its
+// TSC t0 and writes a request, the second one reads its TSC tB and writes it
+// back, the first one reads its TSC t1 on the reply; tB - (t0 + t1) / 2 is the
+// offset, within +/- (t1 - t0) / 2; the round with the shortest round trip
+// gives the tightest bound and is kept
+struct tscSkewSample
+{
+  // TSC of the second CPU - TSC of the first one, in ticks
+  int64_t offset {};
+  // the shortest round trip, in ticks of the first CPU
+  uint_fast64_t roundTrip {};
+  // false when a thread could not be pinned to its CPU, or when the timers
+  // do not read the TSC
+  bool valid {false};
+};
+
+// the TSC offset of cpuB to cpuA, over the given number of ping-pong rounds;
+// the two threads spin, yielding after a while, so that cpuA == cpuB works too
+tscSkewSample measureTscSkew(const uint32_t cpuA,
+                             const uint32_t cpuB,
+                             const unsigned int rounds = 10'000);
+
+// the CPUs the calling thread may run on
+std::vector<uint32_t> allowedCpus();
+
+////////////////////////////////////////////////////////////////////////////////
+// the TSC offsets of every pair of a set of CPUs
+class tscSkewMatrix final
+{
+ public:
+  tscSkewMatrix() = default;
+
+  explicit tscSkewMatrix(const std::vector<uint32_t>& cpus);
+
+  const std::vector<uint32_t>&
+  getCpus() const noexcept
+  {
+    return m_cpus;
+  }
+
+  bool has(const uint32_t cpu) const noexcept;
+
+  // store the sample of fromCpu -> toCpu and its opposite
+  void set(const uint32_t fromCpu, const uint32_t toCpu, const tscSkewSample& s) noexcept;
+
+  // TSC of toCpu - TSC of fromCpu, 0 for a CPU not in the matrix
+  int64_t offset(const uint32_t fromCpu, const uint32_t toCpu) const noexcept;
+
+  uint_fast64_t roundTrip(const uint32_t fromCpu, const uint32_t toCpu) const noexcept;
+
+  // the ticks from start, read on startCpu, to stop, read on stopCpu, with
+  // stop moved back to the TSC of startCpu
+  uint_fast64_t
+  correctedDelta(const uint32_t startCpu,
+                 const uint32_t stopCpu,
+                 const uint_fast64_t start,
+                 const uint_fast64_t stop) const noexcept
+  {
+    return (stop - static_cast<uint_fast64_t>(offset(startCpu, stopCpu))) - start;
+  }
+
+  // the offsets and the round trips, one row per CPU
+  friend std::ostream& operator<<(std::ostream& os, const tscSkewMatrix& obj);
+
+ private:
+  std::vector<uint32_t> m_cpus {};
+  std::vector<int64_t> m_offsets {};
+  std::vector<uint_fast64_t> m_roundTrips {};
+
+  std::size_t indexOf(const uint32_t cpu) const noexcept;
+};  // class tscSkewMatrix
+
+// measure every pair of cpus (by default the CPUs the calling thread may run
+// on); the pairs that cannot be measured are left at 0; an empty matrix when
+// the timers do not read the TSC
+tscSkewMatrix measureTscSkewMatrix(const std::vector<uint32_t>& cpus = allowedCpus(),
+                                   const unsigned int rounds = 10'000);
+////////////////////////////////////////////////////////////////////////////////
+}  // namespace timeSupport
@@ -2,9 +2,29 @@
 //  unitTests.cpp
 //
 #include "../time_support.h"
-
+#include "../async_report_sink.h"
+#include "../benchmark.h"
+#include "../timer_registry.h"
+#include "../prometheus_exporter.h"
+#include "../tsc_skew.h"
+#include "../rate_meter.h"
+#include "../compact_timer.h"
+#include "../coroutine_span.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <new>
+#include <type_traits>
 #include <typeinfo>
 #include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 #include <vector>
 #include <thread>
 #include <gtest/gtest.h>
@@ -19,6 +39,32 @@ using tspec = struct timespec;
 #pragma clang diagnostic ignored "-Wexit-time-destructors"
 #pragma clang diagnostic ignored "-Wglobal-constructors"
 ////////////////////////////////////////////////////////////////////////////////
+// count the allocations made by the tests
+static std::atomic<uint_fast64_t> allocationsCount {0};
+
+void*
+operator new(std::size_t size)
+{
+  allocationsCount.fetch_add(1, std::memory_order_relaxed);
+  if ( void* p = std::malloc((0 == size) ? 1 : size) )
+  {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void
+operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
 [[maybe_unused]]
 static inline
 void
@@ -387,21 +433,17 @@ TEST(timeSupport, rdtscTest_5)
             << ss.str();
 
   std::cout << "Ticks counted: " << rdtsct.getStopLapsedTSC() << '\n';
-#ifdef CHRONO_TIME
   std::cout << "sec   counted: " << rdtsct.getStopLapsed_sec() << '\n';
   std::cout << "msec  counted: " << rdtsct.getStopLapsed_msec() << '\n';
   std::cout << "usec  counted: " << rdtsct.getStopLapsed_usec() << '\n';
   std::cout << "nsec  counted: " << rdtsct.getStopLapsed_nsec() << '\n';
-#endif
   std::cout << "-------------------------"
             << '\n';
 
-#ifdef CHRONO_TIME
   EXPECT_GE(rdtsct.getStopLapsed_sec(),  1.0);
   EXPECT_EQ(rdtsct.getStopLapsed_msec(), 1'000);
   EXPECT_GE(rdtsct.getStopLapsed_usec(), 1'000'000);
   EXPECT_GE(rdtsct.getStopLapsed_nsec(), 1'000'000'000);
-#endif
 }
 
 TEST(timeSupport, rdtscTest_6)
@@ -466,6 +508,1847 @@ TEST(timeSupport, rdtscTest_7)
   ASSERT_NE(ss.str(), "");
 }
 
+TEST(timeSupport, tscClockCalibration)
+{
+  static_assert(timeSupport::tsc_clock::is_steady);
+  static_assert(std::is_same_v<timeSupport::tsc_clock::duration, std::chrono::nanoseconds>);
+
+  const timeSupport::tscCalibration& c = timeSupport::tsc_clock::calibration();
+
+  std::cout << "TSC frequency: "
+            << c.tscHz
+            << " Hz, mult = "
+            << c.mult
+            << ", shift = "
+            << c.shift
+            << '\n';
+
+  ASSERT_GT(c.tscHz, 0);
+
+  // the TSC clock must track CLOCK_MONOTONIC_RAW over a 100 msec sleep
+  tspec&& t0 {};
+  tspec&& t1 {};
+
+  clock_gettime(CLOCK_MONOTONIC_RAW, &t0);
+  auto&& tp0 = timeSupport::tsc_clock::now();
+  nanoSleep(0, 100'000'000);
+  auto&& tp1 = timeSupport::tsc_clock::now();
+  clock_gettime(CLOCK_MONOTONIC_RAW, &t1);
+
+  const auto&& tscNsec = std::chrono::duration_cast<std::chrono::nanoseconds>(tp1 - tp0).count();
+  const auto&& rawNsec = ((t1.tv_sec - t0.tv_sec) * 1'000'000'000) + (t1.tv_nsec - t0.tv_nsec);
+
+  std::cout << "tsc_clock: " << tscNsec << " nsec, CLOCK_MONOTONIC_RAW: " << rawNsec << " nsec" << '\n';
+
+  EXPECT_NEAR(static_cast<double>(tscNsec), static_cast<double>(rawNsec), static_cast<double>(rawNsec) * 0.001);
+}
+
+TEST(timeSupport, tickHistogramBuckets)
+{
+  using timeSupport::tickHistogram;
+
+  ASSERT_EQ(tickHistogram::bucketIndex(0), 0);
+  ASSERT_EQ(tickHistogram::bucketIndex(63), 63);
+  ASSERT_EQ(tickHistogram::bucketIndex(UINT_FAST64_MAX), tickHistogram::bucketCount - 1);
+
+  // every value falls within the bounds of its bucket and the relative
+  // width of a bucket stays below 1 / subBucketCount
+  for (uint_fast64_t&& v {1}; v < (uint_fast64_t{1} << 40); v = (v * 3) / 2 + 1)
+  {
+    auto&& i = tickHistogram::bucketIndex(v);
+    auto&& lo = tickHistogram::bucketLowerBound(i);
+    auto&& hi = tickHistogram::bucketUpperBound(i);
+
+    ASSERT_LE(lo, v);
+    ASSERT_GE(hi, v);
+    ASSERT_LE(static_cast<double>(hi - lo) / static_cast<double>(lo), 1.0 / tickHistogram::subBucketCount);
+  }
+
+  tickHistogram&& h {};
+
+  for (uint_fast64_t&& v {1}; v <= 1'000; ++v)
+  {
+    h.record(v);
+  }
+
+  std::cout << h << '\n';
+
+  EXPECT_EQ(h.getCount(), 1'000);
+  EXPECT_EQ(h.getMin(), 1);
+  EXPECT_EQ(h.getMax(), 1'000);
+  EXPECT_NEAR(static_cast<double>(h.percentile(0.5)), 500.0, 500.0 / tickHistogram::subBucketCount);
+  EXPECT_NEAR(static_cast<double>(h.percentile(0.99)), 990.0, 990.0 / tickHistogram::subBucketCount);
+  EXPECT_EQ(h.percentile(1.0), 1'000);
+}
+
+TEST(timeSupport, latencyHistogramThreads)
+{
+  timeSupport::latencyHistogram histogram {"H"};
+  constexpr uint_fast64_t samplesPerThread {100'000};
+  std::vector<std::thread> threads {};
+
+  for (uint_fast64_t&& t {1}; t <= 4; ++t)
+  {
+    threads.emplace_back([&histogram, t] ()
+    {
+      for (uint_fast64_t&& i {0}; i < samplesPerThread; ++i)
+      {
+        histogram.record(t * 100);
+      }
+    });
+  }
+  for (auto&& t : threads)
+  {
+    t.join();
+  }
+
+  histogram.report();
+
+  auto&& h = histogram.snapshot();
+
+  EXPECT_EQ(h.getCount(), 4 * samplesPerThread);
+  EXPECT_EQ(h.getMin(), 100);
+  EXPECT_EQ(h.getMax(), 400);
+  EXPECT_EQ(h.getSum(), samplesPerThread * (100 + 200 + 300 + 400));
+}
+
+TEST(timeSupport, rdtscTimerHistogramMode)
+{
+  std::stringstream ss {};
+  timeSupport::latencyHistogram histogram {"T-HISTOGRAM"};
+
+  {
+    timeSupport::rdtscTimer rdtsct {"T", ss};
+
+    rdtsct.recordInto(&histogram);
+    for (unsigned int&& i {0}; i < 1'000; ++i)
+    {
+      rdtsct.start("START-POINT").stop("STOP-POINT").report();
+    }
+    ASSERT_EQ(rdtsct.getTimerStatus(), timeSupport::rdtscTimer::rdtscTimerStatus::REPORTED);
+
+    // recorded by the dtor
+    rdtsct.start("START-POINT");
+  }
+
+  histogram.report();
+
+  // nothing is formatted in the log in histogram mode
+  ASSERT_EQ(ss.str(), "");
+  ASSERT_EQ(histogram.snapshot().getCount(), 1'001);
+}
+
+TEST(timeSupport, asyncReportSink)
+{
+  std::stringstream ss {};
+
+  {
+    timeSupport::asyncReportSink sink {ss};
+    std::vector<std::thread> threads {};
+
+    for (unsigned int&& t {0}; t < 4; ++t)
+    {
+      threads.emplace_back([&sink, t] ()
+      {
+        timeSupport::rdtscTimer rdtsct {"T-ASYNC-" + std::to_string(t)};
+
+        rdtsct.reportTo(&sink);
+        for (unsigned int&& i {0}; i < 100; ++i)
+        {
+          rdtsct.start("START-POINT").stopAndReport("STOP-POINT");
+        }
+      });
+    }
+    for (auto&& t : threads)
+    {
+      t.join();
+    }
+
+    sink.flush();
+
+    EXPECT_EQ(sink.getDroppedRecords(), 0);
+    EXPECT_EQ(sink.getWrittenRecords(), 400);
+  }
+
+  auto&& log = ss.str();
+
+  std::cout << log.substr(0, log.find('\n')) << '\n';
+
+  EXPECT_EQ(std::count(log.begin(), log.end(), '\n'), 400);
+  EXPECT_NE(log.find("T-ASYNC-3: START-POINT -> STOP-POINT: Timer started at"), std::string::npos);
+}
+
+TEST(timeSupport, asyncReportSinkDrops)
+{
+  std::stringstream ss {};
+  // a tiny ring that is drained rarely must overflow
+  timeSupport::asyncReportSink sink {ss, 8, std::chrono::milliseconds(10'000)};
+  timeSupport::rdtscTimer rdtsct {"T-DROPS"};
+
+  rdtsct.reportTo(&sink);
+  for (unsigned int&& i {0}; i < 100; ++i)
+  {
+    rdtsct.start("START-POINT").stopAndReport("STOP-POINT");
+  }
+  sink.flush();
+
+  std::cout << "dropped records: " << sink.getDroppedRecords() << '\n';
+
+  EXPECT_EQ(sink.getDroppedRecords() + sink.getWrittenRecords(), 100);
+  EXPECT_GE(sink.getDroppedRecords(), 100 - 8);
+  EXPECT_NE(ss.str().find("records dropped"), std::string::npos);
+}
+
+TEST(timeSupport, internedLabels)
+{
+  auto&& id1 = timeSupport::internLabel("INTERNED-LABEL");
+  auto&& id2 = timeSupport::internLabel(std::string("INTERNED-LABEL"));
+
+  ASSERT_EQ(id1, id2);
+  ASSERT_EQ(timeSupport::labelName(id1), "INTERNED-LABEL");
+  ASSERT_EQ(timeSupport::internLabel(""), timeSupport::noLabel);
+  ASSERT_TRUE(timeSupport::timeLabel{}.empty());
+  ASSERT_EQ(TS_LABEL("INTERNED-LABEL").getId(), id1);
+}
+
+TEST(timeSupport, labelsDoNotAllocate)
+{
+  std::stringstream ss {};
+  timeSupport::latencyHistogram histogram {"T-LABELS"};
+  timeSupport::rdtscTimer rdtsct {"T-LABELS", ss};
+  decltype(auto) nofun = [](){};
+  uint_fast64_t allocations {0};
+
+  // no report line is formatted in histogram mode
+  rdtsct.recordInto(&histogram);
+
+  for (unsigned int&& i {0}; i < 1'000; ++i)
+  {
+    // after the first loop, that interns the labels and creates this
+    // thread's histogram shard, nothing must be allocated
+    if ( 1 == i )
+    {
+      allocations = allocationsCount.load();
+    }
+    rdtsct.start(TS_LABEL("A-START-POINT-LABEL-LONGER-THAN-THE-SSO-BUFFER"))
+          .stop(TS_LABEL("A-STOP-POINT-LABEL-LONGER-THAN-THE-SSO-BUFFER"))
+          .report();
+    rdtsct.start("ANOTHER-START-POINT-LABEL-LONGER-THAN-THE-SSO-BUFFER")
+          .stopAndReport("ANOTHER-STOP-POINT-LABEL-LONGER-THAN-THE-SSO-BUFFER");
+    timeSupport::profileFunction(rdtsct,
+                                 TS_LABEL("START-PROFILE-NOFUN-LONGER-THAN-THE-SSO-BUFFER"),
+                                 TS_LABEL("STOP-PROFILE-NOFUN-LONGER-THAN-THE-SSO-BUFFER"),
+                                 nofun);
+  }
+
+  ASSERT_EQ(allocationsCount.load(), allocations);
+  ASSERT_EQ(histogram.snapshot().getCount(), 3'000);
+  ASSERT_EQ(ss.str(), "");
+}
+
+TEST(timeSupport, binaryTrace)
+{
+  const std::string fileName {"/tmp/time_support_unit_test.trace"};
+  std::stringstream ss {};
+
+  {
+    // small chunks: the trace has to grow many times
+    timeSupport::traceWriter trace {fileName, 512};
+    timeSupport::rdtscTimer rdtsct {"T-TRACE", ss};
+
+    ASSERT_TRUE(trace.isOpen());
+
+    rdtsct.traceTo(&trace);
+    for (unsigned int&& i {0}; i < 1'000; ++i)
+    {
+      rdtsct.start(TS_LABEL("START-POINT-A")).stopAndReport(TS_LABEL("STOP-POINT-A"));
+      rdtsct.start(TS_LABEL("START-POINT-B")).stopAndReport(TS_LABEL("STOP-POINT-B"));
+    }
+
+    EXPECT_EQ(trace.getRecordsCount(), 2'000);
+    EXPECT_EQ(trace.getDroppedRecords(), 0);
+  }
+
+  // nothing is formatted in the log in trace mode
+  ASSERT_EQ(ss.str(), "");
+
+  const timeSupport::traceReader trace {fileName};
+
+  ASSERT_TRUE(trace.isValid()) << trace.getError();
+  ASSERT_EQ(trace.getRecordsCount(), 2'000);
+  EXPECT_EQ(trace.getCalibration().mult, timeSupport::tsc_clock::calibration().mult);
+  EXPECT_EQ(trace.getLabel(trace.getRecord(0).timerId), "T-TRACE");
+  EXPECT_EQ(trace.getLabel(trace.getRecord(1).startLabel), "START-POINT-B");
+  EXPECT_LE(trace.getRecord(0).stop, trace.getRecord(1).start);
+  EXPECT_NE(trace.getRecord(0).startCpu, timeSupport::traceUnknownCpu);
+  EXPECT_NE(trace.getRecord(0).stopCpu, timeSupport::traceUnknownCpu);
+  EXPECT_EQ(trace.getRecord(0).threadId, timeSupport::traceThreadId());
+  EXPECT_EQ(trace.getHeader().processId, static_cast<uint32_t>(getpid()));
+
+  std::stringstream statistics {};
+  std::stringstream csv {};
+
+  timeSupport::writeTraceStatistics(trace, statistics);
+  timeSupport::writeTraceCSV(trace, csv);
+
+  std::cout << statistics.str();
+
+  EXPECT_NE(statistics.str().find("T-TRACE: START-POINT-A -> STOP-POINT-A: 1000 samples:"), std::string::npos);
+  EXPECT_NE(statistics.str().find("T-TRACE: START-POINT-B -> STOP-POINT-B: 1000 samples:"), std::string::npos);
+  const std::string&& lines = csv.str();
+
+  EXPECT_EQ(std::count(lines.begin(), lines.end(), '\n'), 2'001);
+
+  std::stringstream chrome {};
+
+  timeSupport::writeTraceChromeJSON(trace, chrome);
+
+  const std::string&& json = chrome.str();
+
+  EXPECT_EQ(json.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"), 0);
+  EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+  EXPECT_EQ(std::count(json.begin(), json.end(), '\n'), 2'002);
+  EXPECT_NE(json.find("{\"name\":\"T-TRACE\",\"cat\":\"timeSupport\",\"ph\":\"X\",\"pid\":"), std::string::npos);
+  EXPECT_NE(json.find(",\"tid\":" + std::to_string(timeSupport::traceThreadId()) + ",\"ts\":0.000,\"dur\":"), std::string::npos);
+  EXPECT_NE(json.find("\"args\":{\"start\":\"START-POINT-B\",\"stop\":\"STOP-POINT-B\",\"ticks\":"), std::string::npos);
+
+  std::remove(fileName.c_str());
+}
+
+TEST(timeSupport, measurementOverhead)
+{
+  std::stringstream ss {};
+  timeSupport::rdtscTimer rdtsct {"T-OVERHEAD", ss};
+  auto&& overhead = timeSupport::rdtscTimer::getMeasurementOverhead();
+
+  std::cout << "measurement overhead: "
+            << overhead
+            << " ticks, re-measured: "
+            << timeSupport::rdtscTimer::calibrateMeasurementOverhead()
+            << " ticks"
+            << '\n';
+
+  ASSERT_GT(overhead, 0);
+  // measured once per thread
+  ASSERT_EQ(overhead, timeSupport::rdtscTimer::getMeasurementOverhead());
+
+  rdtsct.start("START-POINT").stop("STOP-POINT");
+
+  EXPECT_LE(rdtsct.getStopLapsedTSCCorrected(), rdtsct.getStopLapsedTSC());
+  EXPECT_EQ(rdtsct.getStopLapsedTSCCorrected(),
+            (rdtsct.getStopLapsedTSC() > overhead) ? (rdtsct.getStopLapsedTSC() - overhead) : 0);
+
+  rdtsct.report();
+
+  std::cout << ss.str();
+
+  // the correction is written in the report
+  EXPECT_NE(ss.str().find("corrected for an overhead of " + std::to_string(overhead) + " ticks"), std::string::npos);
+
+  // another thread gets its own measure
+  uint_fast64_t otherOverhead {0};
+  std::thread t {[&otherOverhead] () { otherOverhead = timeSupport::rdtscTimer::getMeasurementOverhead(); }};
+
+  t.join();
+
+  EXPECT_GT(otherOverhead, 0);
+}
+
+template <typename readPolicy>
+timeSupport::tickHistogram
+emptyRegions(const unsigned int samples)
+{
+  std::stringstream ss {};
+  timeSupport::rdtscTimer rdtsct {"T-POLICY", ss};
+  timeSupport::tickHistogram h {};
+
+  for (unsigned int&& i {0}; i < samples; ++i)
+  {
+    rdtsct.start<readPolicy>().template stop<readPolicy>(timeSupport::timeLabel{});
+    h.record(rdtsct.getStopLapsedTSC());
+  }
+  rdtsct.report();
+
+  return h;
+}
+
+TEST(timeSupport, readPolicies)
+{
+  constexpr unsigned int samples {100'000};
+  const std::vector<std::pair<const char*, timeSupport::tickHistogram>> costs {
+    {"rdtsc",              emptyRegions<timeSupport::tscRdtsc>(samples)},
+    {"lfence;rdtsc",       emptyRegions<timeSupport::tscLfenceRdtsc>(samples)},
+    {"rdtscp",             emptyRegions<timeSupport::tscRdtscp>(samples)},
+    {"rdtscp;lfence",      emptyRegions<timeSupport::tscRdtscpLfence>(samples)},
+    {"cpuid;rdtsc/rdtscp;cpuid", emptyRegions<timeSupport::tscCpuidSerialized>(samples)}
+  };
+
+  for (auto&& c : costs)
+  {
+    const timeSupport::tickHistogram& h = c.second;
+
+    std::cout << c.first
+              << ": empty region: min "
+              << h.getMin()
+              << " p50 "
+              << h.percentile(0.50)
+              << " p99 "
+              << h.percentile(0.99)
+              << " max "
+              << h.getMax()
+              << " ticks"
+              << '\n';
+
+    ASSERT_EQ(h.getCount(), samples);
+    EXPECT_LE(h.getMin(), h.percentile(0.50));
+    EXPECT_LT(h.percentile(0.50), 1'000'000);
+  }
+
+  // each policy reads a TSC consistent with the others
+  auto&& t0 = timeSupport::startTSC<timeSupport::tscRdtsc>();
+  auto&& t1 = timeSupport::startTSC<timeSupport::tscLfenceRdtsc>();
+  auto&& t2 = timeSupport::startTSC<timeSupport::tscCpuidSerialized>();
+  auto&& t3 = timeSupport::stopTSC<timeSupport::tscRdtscpLfence>();
+  auto&& t4 = timeSupport::stopTSC<timeSupport::tscCpuidSerialized>();
+  auto&& t5 = timeSupport::stopTSC();
+
+  EXPECT_LE(t0, t1);
+  EXPECT_LE(t1, t2);
+  EXPECT_LE(t2, t3);
+  EXPECT_LE(t3, t4);
+  EXPECT_LE(t4, t5);
+}
+
+TEST(timeSupport, crossCoreSamples)
+{
+  cpu_set_t allowed {};
+
+  ASSERT_EQ(sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+
+  std::vector<int> cpus {};
+
+  for (int&& cpu {0}; cpu < CPU_SETSIZE; ++cpu)
+  {
+    if ( CPU_ISSET(cpu, &allowed) )
+    {
+      cpus.push_back(cpu);
+    }
+  }
+
+  auto&& pinTo = [] (const int cpu)
+  {
+    cpu_set_t set {};
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set);
+  };
+
+  std::stringstream ss {};
+  timeSupport::latencyHistogram kept {"KEPT"};
+  timeSupport::latencyHistogram dropped {"DROPPED"};
+  timeSupport::rdtscTimer keeper {"T-KEEP", ss};
+  timeSupport::rdtscTimer dropper {"T-DROP", ss};
+  timeSupport::rdtscTimer liner {"T-LINE", ss};
+
+  keeper.recordInto(&kept);
+  dropper.recordInto(&dropped).setCrossCorePolicy(timeSupport::rdtscTimer::crossCorePolicy::DROP);
+
+  ASSERT_EQ(pinTo(cpus.front()), 0);
+  keeper.start("START-POINT");
+  dropper.start("START-POINT");
+  liner.start("START-POINT");
+
+  // the CPU comes with the ticks
+  EXPECT_EQ(keeper.getStartCpu(), static_cast<uint32_t>(cpus.front()));
+
+  const bool migrated {(cpus.size() > 1) && (0 == pinTo(cpus.back()))};
+
+  keeper.stop("STOP-POINT");
+  dropper.stop("STOP-POINT");
+  liner.stop("STOP-POINT").report();
+  sched_setaffinity(0, sizeof(allowed), &allowed);
+
+  std::cout << ss.str();
+
+  EXPECT_EQ(keeper.isCrossCore(), migrated);
+  EXPECT_EQ(keeper.getCrossCoreSamples(), migrated ? 1 : 0);
+  EXPECT_EQ(dropper.getCrossCoreSamples(), migrated ? 1 : 0);
+  EXPECT_EQ(kept.snapshot().getCount(), 1);
+  EXPECT_EQ(dropped.snapshot().getCount(), migrated ? 0 : 1);
+  EXPECT_EQ(ss.str().find("CROSS-CORE") != std::string::npos, migrated);
+
+  // written when both CPUs are known and differ
+  std::stringstream line {};
+
+  timeSupport::rdtscTimer::writeReport(line, "T", "A", "B", 100, 200, 10, 1, 2);
+  timeSupport::rdtscTimer::writeReport(line, "T", "A", "B", 100, 200, 10, 2, 2);
+  timeSupport::rdtscTimer::writeReport(line, "T", "A", "B", 100, 200, 10, timeSupport::unknownCpu, 2);
+  const std::string&& lines = line.str();
+
+  EXPECT_NE(lines.find("CROSS-CORE: cpu 1 -> cpu 2\n"), std::string::npos);
+  EXPECT_EQ(lines.find("CROSS-CORE"), lines.rfind("CROSS-CORE"));
+
+  // the reads without rdtscp do not know the CPU
+  timeSupport::rdtscTimer rdtsct {"T-RDTSC", ss};
+
+  rdtsct.start<timeSupport::tscRdtsc>("START-POINT").stop<timeSupport::tscRdtsc>("STOP-POINT");
+  EXPECT_EQ(rdtsct.getStartCpu(), timeSupport::unknownCpu);
+  EXPECT_EQ(rdtsct.getStopCpu(), timeSupport::unknownCpu);
+  EXPECT_FALSE(rdtsct.isCrossCore());
+}
+
+static
+uint_fast64_t
+zonedWork(const uint_fast64_t n) noexcept
+{
+  TIME_ZONE("zonedWork");
+  uint_fast64_t&& r {0};
+
+  for (uint_fast64_t&& i {0}; i < n; ++i)
+  {
+    r += i * i;
+  }
+  return r;
+}
+
+TEST(timeSupport, timeZones)
+{
+  constexpr unsigned int calls {1'000};
+  std::atomic<uint_fast64_t> sink {0};
+
+  auto&& work = [&sink] ()
+  {
+    for (unsigned int&& i {0}; i < calls; ++i)
+    {
+      sink += zonedWork(i);
+    }
+  };
+
+  work();
+
+  // created once per call site
+  const std::size_t zones {timeSupport::zonesCount()};
+
+  std::thread t1 {work};
+  std::thread t2 {work};
+
+  t1.join();
+  t2.join();
+  {
+    TIME_ZONE("scope");
+  }
+
+  ASSERT_EQ(timeSupport::zonesCount(), zones + 1);
+
+  const timeSupport::zoneDescriptor* zone {nullptr};
+
+  for (auto&& z = timeSupport::firstZone(); nullptr != z; z = z->getNext())
+  {
+    if ( std::string("zonedWork") == z->getName() )
+    {
+      zone = z;
+    }
+  }
+  ASSERT_NE(zone, nullptr);
+  EXPECT_EQ(timeSupport::labelName(zone->getLabel()), "zonedWork");
+  EXPECT_NE(std::string(zone->getFile()).find("unitTests.cpp"), std::string::npos);
+
+  const timeSupport::zoneStatistics&& s = zone->snapshot();
+
+  EXPECT_EQ(s.count, 3 * calls);
+  EXPECT_LE(s.min, s.max);
+  EXPECT_GE(s.sum, s.count * s.min);
+
+  // entering a zone neither locks nor allocates after the first call of a thread
+  const uint_fast64_t allocations {allocationsCount.load()};
+
+  sink += zonedWork(10);
+  EXPECT_EQ(allocationsCount.load(), allocations);
+
+  std::stringstream ss {};
+
+  timeSupport::dumpZones(ss);
+  std::cout << ss.str();
+
+  EXPECT_NE(ss.str().find("zonedWork ("), std::string::npos);
+  EXPECT_NE(ss.str().find(": 3001 calls: total "), std::string::npos);
+  EXPECT_NE(ss.str().find("scope ("), std::string::npos);
+}
+
+static
+uint_fast64_t
+nestedLeaf(const uint_fast64_t n) noexcept
+{
+  TIME_NESTED_ZONE("leaf");
+  uint_fast64_t&& r {0};
+
+  for (uint_fast64_t&& i {0}; i < n; ++i)
+  {
+    r += i * i;
+  }
+  return r;
+}
+
+static
+uint_fast64_t
+nestedRequest() noexcept
+{
+  TIME_NESTED_ZONE("request");
+  uint_fast64_t&& r {0};
+
+  {
+    TIME_NESTED_ZONE("parse");
+    r += nestedLeaf(100);
+  }
+  {
+    TIME_NESTED_ZONE("handle");
+    r += nestedLeaf(1'000);
+    r += nestedLeaf(1'000);
+  }
+  return r;
+}
+
+TEST(timeSupport, nestedZones)
+{
+  std::atomic<uint_fast64_t> sink {0};
+
+  auto&& work = [&sink] ()
+  {
+    for (unsigned int&& i {0}; i < 100; ++i)
+    {
+      sink += nestedRequest();
+    }
+  };
+
+  work();
+
+  std::thread t {work};
+
+  t.join();
+
+  const timeSupport::callTreeStatistics&& root = timeSupport::mergeCallTrees();
+
+  auto&& child = [] (const timeSupport::callTreeStatistics& node, const std::string& name)
+  {
+    auto&& it = std::find_if(node.children.begin(), node.children.end(), [&name] (auto&& c)
+    {
+      return name == c.zone->getName();
+    });
+
+    return (node.children.end() == it) ? nullptr : &*it;
+  };
+
+  auto&& request = child(root, "request");
+
+  ASSERT_NE(request, nullptr);
+  ASSERT_EQ(request->calls, 200);
+  ASSERT_EQ(request->children.size(), 2);
+
+  auto&& parse = child(*request, "parse");
+  auto&& handle = child(*request, "handle");
+
+  ASSERT_NE(parse, nullptr);
+  ASSERT_NE(handle, nullptr);
+  EXPECT_EQ(parse->calls, 200);
+  EXPECT_EQ(handle->calls, 200);
+
+  // the same zone under two parents is two nodes
+  auto&& parseLeaf = child(*parse, "leaf");
+  auto&& handleLeaf = child(*handle, "leaf");
+
+  ASSERT_NE(parseLeaf, nullptr);
+  ASSERT_NE(handleLeaf, nullptr);
+  EXPECT_EQ(parseLeaf->calls, 200);
+  EXPECT_EQ(handleLeaf->calls, 400);
+  EXPECT_EQ(handleLeaf->inclusive, handleLeaf->exclusive);
+
+  // no double counting: the children are inside their parent
+  EXPECT_GE(request->inclusive, parse->inclusive + handle->inclusive);
+  EXPECT_EQ(request->exclusive, request->inclusive - (parse->inclusive + handle->inclusive));
+  EXPECT_EQ(handle->exclusive, handle->inclusive - handleLeaf->inclusive);
+
+  std::stringstream ss {};
+
+  timeSupport::dumpCallTree(ss);
+  std::cout << ss.str();
+
+  EXPECT_NE(ss.str().find("request: 200 calls: inclusive "), std::string::npos);
+  EXPECT_NE(ss.str().find("\n    leaf: 400 calls: inclusive "), std::string::npos);
+}
+
+static
+uint_fast64_t
+sumOfSquares(const uint_fast64_t n) noexcept
+{
+  uint_fast64_t&& r {0};
+
+  for (uint_fast64_t&& i {0}; i < n; ++i)
+  {
+    timeSupport::doNotOptimize(i);
+    r += i * i;
+  }
+  return r;
+}
+
+TEST(timeSupport, benchmarkRunner)
+{
+  timeSupport::benchmarkOptions options {};
+
+  options.warmupTime = std::chrono::milliseconds(5);
+  options.minTime = std::chrono::milliseconds(20);
+
+  const timeSupport::benchmarkResult&& small = timeSupport::runBenchmark(options, "sumOfSquares(100)", sumOfSquares, 100);
+  const timeSupport::benchmarkResult&& large = timeSupport::runBenchmark(options, "sumOfSquares(10000)", sumOfSquares, 10'000);
+
+  std::cout << small << '\n' << large << '\n';
+
+  for (auto&& r : {small, large})
+  {
+    EXPECT_GE(r.samples + r.rejected, options.minSamples);
+    EXPECT_LE(r.samples + r.rejected, options.maxSamples);
+    EXPECT_LT(r.rejected, r.samples);
+    EXPECT_GE(r.iterationsPerSample, 1);
+    EXPECT_LE(r.min, r.median);
+    EXPECT_LE(r.median, r.p99);
+    EXPECT_LE(r.ciLow, r.mean);
+    EXPECT_GE(r.ciHigh, r.mean);
+  }
+  EXPECT_GT(small.iterationsPerSample, large.iterationsPerSample);
+  EXPECT_GT(large.median, 10 * small.median);
+
+  // a lambda with no result; the default options
+  std::vector<int> v(64);
+  const timeSupport::benchmarkResult&& fill = timeSupport::runBenchmark("fill", [&v] ()
+  {
+    std::fill(v.begin(), v.end(), 1);
+    timeSupport::clobberMemory();
+  });
+
+  std::cout << fill << '\n';
+  EXPECT_GT(fill.samples, 0);
+
+  // the outliers are rejected by their distance from the median
+  std::vector<double> samples(100);
+
+  for (unsigned int&& i {0}; i < samples.size(); ++i)
+  {
+    samples[i] = 9.0 + (i % 3);
+  }
+  samples[99] = 1'000.0;
+
+  const timeSupport::benchmarkResult&& r = timeSupport::summarizeBenchmark("synthetic", samples, 1, options);
+
+  EXPECT_EQ(r.rejected, 1);
+  EXPECT_EQ(r.samples, 99);
+  EXPECT_DOUBLE_EQ(r.median, 10.0);
+  EXPECT_DOUBLE_EQ(r.min, 9.0);
+  EXPECT_LT(r.p99, 1'000.0);
+}
+
+TEST(timeSupport, laps)
+{
+  std::stringstream ss {};
+  timeSupport::rdtscTimer rdtsct {"T-LAPS", ss};
+
+  rdtsct.start(TS_LABEL("RECEIVE"));
+  sumOfSquares(10);
+  rdtsct.lap(TS_LABEL("PARSE"));
+  sumOfSquares(100'000);
+  rdtsct.lap(TS_LABEL("HANDLE"));
+  rdtsct.stop(TS_LABEL("REPLY"));
+
+  ASSERT_EQ(rdtsct.getLapsCount(), 2);
+  EXPECT_EQ(rdtsct.getLapLabel(0).getName(), "PARSE");
+  EXPECT_EQ(rdtsct.getLapLabel(1).getName(), "HANDLE");
+  // no gap between the stages
+  EXPECT_EQ(rdtsct.getLapDeltaTSC(0) + rdtsct.getLapDeltaTSC(1) + (rdtsct.getStopTSC() - rdtsct.getLapTSC(1)),
+            rdtsct.getStopLapsedTSC());
+  EXPECT_GT(rdtsct.getLapDeltaTSC(1), rdtsct.getLapDeltaTSC(0));
+
+  rdtsct.writeLaps(ss);
+  rdtsct.report();
+  std::cout << ss.str();
+  EXPECT_NE(ss.str().find("T-LAPS: lap 0: RECEIVE -> PARSE: "), std::string::npos);
+  EXPECT_NE(ss.str().find("T-LAPS: lap 2: HANDLE -> REPLY: "), std::string::npos);
+
+  // start() clears the laps, the ones beyond the capacity are dropped
+  rdtsct.start(TS_LABEL("RECEIVE"));
+  EXPECT_EQ(rdtsct.getLapsCount(), 0);
+  for (std::size_t&& i {0}; i < timeSupport::rdtscTimer::maxLaps + 2; ++i)
+  {
+    rdtsct.lap(TS_LABEL("LAP"));
+  }
+  rdtsct.stop(TS_LABEL("REPLY"));
+  EXPECT_EQ(rdtsct.getLapsCount(), timeSupport::rdtscTimer::maxLaps);
+  EXPECT_EQ(rdtsct.getDroppedLaps(), 2);
+
+  // the stages of many runs
+  timeSupport::stageStatistics stages {"pipeline", 3};
+  timeSupport::rdtscTimer pipeline {"T-PIPELINE", ss};
+  constexpr unsigned int runs {1'000};
+
+  pipeline.recordStagesInto(&stages);
+
+  uint_fast64_t allocations {0};
+
+  for (unsigned int&& i {0}; i < runs; ++i)
+  {
+    // the first run creates the thread's shards of the stages
+    if ( 1 == i )
+    {
+      allocations = allocationsCount.load();
+    }
+    pipeline.start(TS_LABEL("RECEIVE"));
+    sumOfSquares(10);
+    pipeline.lap(TS_LABEL("PARSE"));
+    sumOfSquares(1'000);
+    pipeline.lap(TS_LABEL("HANDLE"));
+    pipeline.stop(TS_LABEL("REPLY")).report();
+  }
+  // laps neither lock nor allocate
+  EXPECT_EQ(allocationsCount.load(), allocations);
+
+  // a run with too many laps
+  pipeline.start(TS_LABEL("RECEIVE")).lap(TS_LABEL("A")).lap(TS_LABEL("B")).lap(TS_LABEL("C")).stop(TS_LABEL("REPLY"));
+
+  EXPECT_EQ(stages.getRuns(), runs + 1);
+  EXPECT_EQ(stages.getDroppedStages(), 1);
+  EXPECT_EQ(stages.snapshot(0).getCount(), runs + 1);
+  EXPECT_EQ(stages.snapshot(2).getCount(), runs + 1);
+  EXPECT_EQ(timeSupport::labelName(stages.getStageFrom(1)), "PARSE");
+  EXPECT_EQ(timeSupport::labelName(stages.getStageTo(1)), "HANDLE");
+  EXPECT_GT(stages.snapshot(1).percentile(0.5), stages.snapshot(0).percentile(0.5));
+
+  std::stringstream report {};
+
+  stages.report(report);
+  std::cout << report.str();
+  EXPECT_NE(report.str().find("pipeline: stage 1: PARSE -> HANDLE: "), std::string::npos);
+}
+
+TEST(timeSupport, nullTimer)
+{
+  static_assert(std::is_same_v<timeSupport::timer<>, timeSupport::rdtscTimer>);
+  static_assert(std::is_same_v<timeSupport::timer<timeSupport::nullBackend>, timeSupport::nullTimer>);
+  static_assert(std::is_empty_v<timeSupport::nullTimer>);
+  static_assert(std::is_trivially_destructible_v<timeSupport::nullTimer>);
+
+  // the null backend neither logs, nor allocates, nor reads the clock
+  std::stringstream ss {};
+  timeSupport::latencyHistogram histogram {"null"};
+  const uint_fast64_t allocations {allocationsCount.load()};
+  timeSupport::timer<timeSupport::nullBackend> nullt {"T-NULL", ss};
+
+  nullt.recordInto(&histogram);
+  nullt.stop("STOP-NOT-STARTED");
+  for (int&& i {0}; i < 1'000; ++i)
+  {
+    nullt.start<timeSupport::tscCpuidSerialized>("START").lap("LAP").stop("STOP").report();
+  }
+  nullt.stopAndReport("STOP");
+  nullt();
+  EXPECT_EQ(allocationsCount.load(), allocations);
+  EXPECT_TRUE(ss.str().empty());
+  EXPECT_EQ(histogram.snapshot().getCount(), 0);
+  EXPECT_EQ(nullt.getStopLapsedTSC(), 0);
+  EXPECT_EQ(nullt.getTimerStatus(), timeSupport::nullTimer::rdtscTimerStatus::INACTIVE);
+
+  // the same instrumented code with either backend: only func is left
+  int calls {0};
+  auto&& f = [&calls] (const int n)
+  {
+    calls += n;
+  };
+  timeSupport::timer<timeSupport::tscBackend> rdtsct {"T-TSC", ss};
+
+  timeSupport::profileFunction(nullt, TS_LABEL("START"), TS_LABEL("STOP"), f, 1);
+  timeSupport::profileFunction(rdtsct, TS_LABEL("START"), TS_LABEL("STOP"), f, 2);
+  EXPECT_EQ(calls, 3);
+  EXPECT_EQ(rdtsct.getTimerStatus(), timeSupport::rdtscTimer::rdtscTimerStatus::REPORTED);
+  EXPECT_NE(ss.str().find("T-TSC"), std::string::npos);
+}
+
+// instrumented code that uses the whole API of a timer; it must compile with
+// every backend
+template <typename backend>
+uint_fast64_t
+instrumentedCode(timeSupport::timer<backend>& t, std::ostream& os)
+{
+  using timerType = timeSupport::timer<backend>;
+
+  const timeSupport::tscSkewMatrix skew {};
+  uint_fast64_t ticks {0};
+
+  t.setCrossCorePolicy(timerType::crossCorePolicy::KEEP).sampleEvery(1).clearBudget().watchWith(nullptr);
+  t.recordInto(nullptr).traceTo(nullptr).reportTo(nullptr).recordStagesInto(nullptr).attachCounters(nullptr);
+  t.start(TS_LABEL("START"));
+  sumOfSquares(100);
+  t.lap(TS_LABEL("LAP"));
+  sumOfSquares(100);
+  t.stop(TS_LABEL("STOP"));
+  t.writeLaps(os);
+  if ( t.getLapsCount() > 0 )
+  {
+    os << t.getLapLabel(0) << ' ' << t.getLapTSC(0) << ' ' << t.getLapDeltaTSC(0) << '\n';
+  }
+  os << t.getStartLabel() << " -> " << t.getStopLabel() << ' ' << t.getTimerStatusString() << '\n';
+  os << t.getStartCpu() << ' ' << t.getStopCpu() << ' ' << t.isCrossCore() << ' ' << t.getCrossCoreSamples() << '\n';
+  os << t.getStopLapsed_sec() << ' ' << t.getStopLapsed_msec() << ' ' << t.getStopLapsed_usec() << ' '
+     << t.getStopLapsed_nsec() << ' ' << t.getStopLapsed_nsecCorrected() << '\n';
+  os << t << '\n';
+  timerType::writeReport(os, "T", "START", "STOP", 0, 1, 0);
+  ticks += t.getStopLapsedTSC() + t.getStopLapsedTSCCorrected() + t.getStopLapsedTSCSkewCorrected(skew);
+  ticks += t.getStartTSC() + t.getStopTSC() + t.getLapsedTSC();
+  ticks += t.getDroppedLaps() + t.getOverBudgetCount() + t.getCountersDelta().available;
+  ticks += timerType::getMeasurementOverhead() + timerType::calibrateMeasurementOverhead(100);
+  EXPECT_EQ(t.getHistogram(), nullptr);
+  EXPECT_EQ(t.getTrace(), nullptr);
+  EXPECT_EQ(t.getReportSink(), nullptr);
+  EXPECT_EQ(t.getStageStatistics(), nullptr);
+  EXPECT_EQ(t.getCounters(), nullptr);
+  EXPECT_EQ(t.getWatchdog(), nullptr);
+  EXPECT_EQ(t.getCrossCorePolicy(), timerType::crossCorePolicy::KEEP);
+  EXPECT_EQ(t.getBudget(), UINT_FAST64_MAX);
+  EXPECT_EQ(t.getSampleWeight(), 1);
+  EXPECT_FALSE(t.isSampledOut());
+  t.setBudget(UINT_FAST64_MAX).report();
+  t();
+  return ticks;
+}
+
+TEST(timeSupport, nullTimerApi)
+{
+  std::stringstream nullLog {};
+  std::stringstream nullOut {};
+  timeSupport::timer<timeSupport::nullBackend> nullt {"T-NULL", nullLog};
+
+  EXPECT_EQ(instrumentedCode<timeSupport::nullBackend>(nullt, nullOut), 0);
+  EXPECT_TRUE(nullLog.str().empty());
+  EXPECT_EQ(nullOut.str(), " ->  INACTIVE\n" +
+                           std::to_string(timeSupport::unknownCpu) + ' ' + std::to_string(timeSupport::unknownCpu) + " 0 0\n" +
+                           "0 0 0 0 0\n\n");
+
+  std::stringstream tscLog {};
+  std::stringstream tscOut {};
+  timeSupport::timer<timeSupport::tscBackend> rdtsct {"T-TSC", tscLog};
+
+  EXPECT_GT(instrumentedCode<timeSupport::tscBackend>(rdtsct, tscOut), 0);
+  EXPECT_NE(tscLog.str().find("T-TSC"), std::string::npos);
+  EXPECT_NE(tscOut.str().find("START -> STOP STOPPED\n"), std::string::npos);
+  EXPECT_EQ(rdtsct.getTimerStatus(), timeSupport::rdtscTimer::rdtscTimerStatus::REPORTED);
+}
+
+TEST(timeSupport, perfCounters)
+{
+  timeSupport::perfCounterGroup counters {};
+
+  if ( !counters.getError().empty() )
+  {
+    std::cout << "some counters are not available: " << counters.getError() << '\n';
+  }
+
+  std::stringstream ss {};
+  timeSupport::rdtscTimer rdtsct {"T-PMU", ss};
+
+  rdtsct.attachCounters(&counters);
+  rdtsct.start(TS_LABEL("START"));
+  sumOfSquares(100'000);
+  std::this_thread::yield();
+  rdtsct.stop(TS_LABEL("STOP")).report();
+  std::cout << ss.str();
+
+  const timeSupport::perfCounterValues&& delta = rdtsct.getCountersDelta();
+
+  for (std::size_t&& i {0}; i < timeSupport::perfCountersCount; ++i)
+  {
+    const timeSupport::perfCounter c {static_cast<timeSupport::perfCounter>(i)};
+
+    EXPECT_EQ(delta.has(c), counters.isAvailable(c));
+  }
+  if ( counters.isAvailable(timeSupport::perfCounter::CYCLES) &&
+       counters.isAvailable(timeSupport::perfCounter::INSTRUCTIONS) )
+  {
+    EXPECT_GT(delta.get(timeSupport::perfCounter::INSTRUCTIONS), 100'000);
+    EXPECT_GT(delta.ipc(), 0.0);
+    EXPECT_NE(ss.str().find("IPC "), std::string::npos);
+  }
+  if ( counters.isAvailable() )
+  {
+    EXPECT_NE(ss.str().find(" PMU: "), std::string::npos);
+  }
+  else
+  {
+    // graceful fallback: a plain report
+    EXPECT_EQ(ss.str().find(" PMU: "), std::string::npos);
+    EXPECT_NE(ss.str().find("T-PMU: START -> STOP: "), std::string::npos);
+  }
+
+  // detached counters are not read
+  rdtsct.attachCounters(nullptr);
+  rdtsct.start(TS_LABEL("START"));
+  rdtsct.stop(TS_LABEL("STOP"));
+  EXPECT_EQ(rdtsct.getCountersDelta().available, 0);
+}
+
+TEST(timeSupport, timerRegistry)
+{
+  timeSupport::timerRegistry registry {};
+  constexpr unsigned int threadsCount {4};
+  constexpr unsigned int samples {10'000};
+  std::vector<std::thread> threads {};
+
+  for (unsigned int&& t {0}; t < threadsCount; ++t)
+  {
+    threads.emplace_back([&registry] ()
+    {
+      timeSupport::sharedTimer& shared {registry.get("T-SHARED")};
+      timeSupport::rdtscTimer& rdtsct {shared.local()};
+
+      for (unsigned int&& i {0}; i < samples; ++i)
+      {
+        rdtsct.start(TS_LABEL("REQUEST"));
+        sumOfSquares(10);
+        rdtsct.stop(TS_LABEL("REPLY")).report();
+      }
+      // a thread's timer is the same at every call
+      EXPECT_EQ(&rdtsct, &shared.local());
+    });
+  }
+  for (auto&& t : threads)
+  {
+    t.join();
+  }
+
+  timeSupport::sharedTimer& shared {registry.get("T-SHARED")};
+
+  EXPECT_EQ(registry.size(), 1);
+  EXPECT_EQ(registry.find("T-SHARED"), &shared);
+  EXPECT_EQ(registry.find("T-NONE"), nullptr);
+  EXPECT_EQ(shared.getThreadsCount(), threadsCount);
+  // no sample lost
+  EXPECT_EQ(shared.snapshot().getCount(), threadsCount * samples);
+
+  // this thread's timer, left started, records at destruction
+  registry.get("T-OTHER").record(100);
+  registry.get("T-OTHER").local().start(TS_LABEL("REQUEST"));
+
+  std::stringstream ss {};
+
+  registry.report(ss);
+  std::cout << ss.str();
+  EXPECT_LT(ss.str().find("T-OTHER: "), ss.str().find("T-SHARED: "));
+  EXPECT_EQ(&timeSupport::timerRegistry::global(), &timeSupport::timerRegistry::global());
+}
+
+TEST(timeSupport, prometheusExporter)
+{
+  timeSupport::timerRegistry registry {};
+  timeSupport::sharedTimer& shared {registry.get("T-PROM")};
+
+  for (unsigned int&& i {0}; i < 1'000; ++i)
+  {
+    shared.local().start(TS_LABEL("REQUEST"));
+    sumOfSquares(10);
+    shared.local().stop(TS_LABEL("REPLY"));
+  }
+  registry.get("T-\"QUOTED\"").record(100);
+
+  std::stringstream ss {};
+
+  timeSupport::writePrometheus(registry, ss);
+
+  const std::string&& text = ss.str();
+
+  EXPECT_NE(text.find("# TYPE timesupport_timer_seconds histogram\n"), std::string::npos);
+  EXPECT_NE(text.find("timesupport_timer_seconds_bucket{timer=\"T-PROM\",le=\"+Inf\"} 1000\n"), std::string::npos);
+  EXPECT_NE(text.find("timesupport_timer_seconds_count{timer=\"T-PROM\"} 1000\n"), std::string::npos);
+  EXPECT_NE(text.find("timesupport_timer_seconds_sum{timer=\"T-PROM\"} "), std::string::npos);
+  EXPECT_NE(text.find("timesupport_timer_seconds_count{timer=\"T-\\\"QUOTED\\\"\"} 1\n"), std::string::npos);
+
+  // the buckets are cumulative, with the same fixed le bounds for every timer
+  std::istringstream lines {text};
+  std::string line {};
+  uint_fast64_t previous {0};
+  std::vector<std::string> bounds {};
+  std::vector<std::string> quotedBounds {};
+
+  while ( std::getline(lines, line) )
+  {
+    const std::string&& le = line.substr(line.find(",le=") + 1, line.rfind(' ') - line.find(",le=") - 1);
+
+    if ( 0 == line.find("timesupport_timer_seconds_bucket{timer=\"T-PROM\"") )
+    {
+      const uint_fast64_t count {std::stoull(line.substr(line.rfind(' ') + 1))};
+
+      EXPECT_GE(count, previous);
+      previous = count;
+      bounds.push_back(le);
+    }
+    else if ( 0 == line.find("timesupport_timer_seconds_bucket{timer=\"T-\\\"QUOTED\\\"\"") )
+    {
+      quotedBounds.push_back(le);
+    }
+  }
+  EXPECT_EQ(previous, 1'000);
+  EXPECT_EQ(bounds, quotedBounds);
+  // 1-2-5 steps from 100 nsec to 100 sec, and +Inf
+  ASSERT_EQ(bounds.size(), 29);
+  EXPECT_EQ(bounds.front(), "le=\"1e-07\"}");
+  EXPECT_EQ(bounds[12], "le=\"0.001\"}");
+  EXPECT_EQ(bounds[27], "le=\"100\"}");
+  EXPECT_EQ(bounds.back(), "le=\"+Inf\"}");
+
+  // the same bounds when nothing was recorded
+  std::stringstream empty {};
+  timeSupport::timerRegistry emptyRegistry {};
+
+  emptyRegistry.get("T-EMPTY");
+  timeSupport::writePrometheus(emptyRegistry, empty);
+  EXPECT_NE(empty.str().find("timesupport_timer_seconds_bucket{timer=\"T-EMPTY\",le=\"1e-07\"} 0\n"), std::string::npos);
+  EXPECT_NE(empty.str().find("timesupport_timer_seconds_bucket{timer=\"T-EMPTY\",le=\"100\"} 0\n"), std::string::npos);
+
+  // on demand and periodic file export, read while the timer records
+  const std::string&& fileName = "/tmp/timeSupport_" + std::to_string(getpid()) + ".prom";
+
+  ASSERT_TRUE(timeSupport::writePrometheusFile(registry, fileName));
+  {
+    timeSupport::prometheusExporter exporter {registry, fileName, std::chrono::milliseconds(5)};
+
+    // bounded by time, not by iterations: a fast CPU runs 100'000 of them
+    // before the first period ends
+    const auto&& deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+    while ( (exporter.getExportsCount() < 3) && (std::chrono::steady_clock::now() < deadline) )
+    {
+      shared.local().start(TS_LABEL("REQUEST"));
+      shared.local().stop(TS_LABEL("REPLY"));
+    }
+    EXPECT_GE(exporter.getExportsCount(), 1);
+    EXPECT_EQ(exporter.getFailedExports(), 0);
+  }
+
+  std::ifstream f {fileName};
+  const std::string content {std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+
+  EXPECT_NE(content.find("timesupport_timer_seconds_count{timer=\"T-PROM\"} "), std::string::npos);
+  std::remove(fileName.c_str());
+
+  // scrape the Unix socket endpoint
+  const std::string&& socketPath = "/tmp/timeSupport_" + std::to_string(getpid()) + ".sock";
+  timeSupport::prometheusEndpoint endpoint {registry, socketPath};
+
+  ASSERT_TRUE(endpoint.isOpen());
+
+  const int fd {socket(AF_UNIX, SOCK_STREAM, 0)};
+  sockaddr_un address {};
+
+  address.sun_family = AF_UNIX;
+  std::strcpy(address.sun_path, socketPath.c_str());
+  ASSERT_EQ(connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)), 0);
+
+  const std::string request {"GET /metrics HTTP/1.0\r\n\r\n"};
+
+  ASSERT_EQ(send(fd, request.data(), request.size(), 0), static_cast<ssize_t>(request.size()));
+
+  std::string response {};
+  char buffer[4096];
+  ssize_t n {0};
+
+  while ( (n = recv(fd, buffer, sizeof(buffer), 0)) > 0 )
+  {
+    response.append(buffer, static_cast<std::size_t>(n));
+  }
+  close(fd);
+
+  EXPECT_EQ(response.find("HTTP/1.0 200 OK\r\n"), 0);
+  EXPECT_NE(response.find("Content-Type: text/plain; version=0.0.4\r\n"), std::string::npos);
+  EXPECT_NE(response.find("timesupport_timer_seconds_count{timer=\"T-PROM\"} "), std::string::npos);
+  EXPECT_EQ(endpoint.getScrapesCount(), 1);
+}
+
+TEST(timeSupport, clockBackend)
+{
+  const timeSupport::clockBackend selected {timeSupport::activeClockBackend()};
+  const timeSupport::clockSupport&& support = timeSupport::detectClockSupport();
+
+  timeSupport::writeClockSupport(std::cout);
+  EXPECT_EQ(selected == timeSupport::clockBackend::TSC, support.isTSCReliable());
+
+  // the fallback reads nanoseconds with an identity calibration
+  timeSupport::forceClockBackend(timeSupport::clockBackend::MONOTONIC_RAW);
+  EXPECT_EQ(timeSupport::activeClockBackend(), timeSupport::clockBackend::MONOTONIC_RAW);
+  EXPECT_EQ(timeSupport::tsc_clock::calibration().tscHz, 1'000'000'000);
+  EXPECT_EQ(timeSupport::tsc_clock::toNanoseconds(12'345), 12'345);
+  {
+    std::stringstream ss {};
+    timeSupport::rdtscTimer rdtsct {"T-FALLBACK", ss};
+
+    rdtsct.start<timeSupport::tscCpuidSerialized>(TS_LABEL("START"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    rdtsct.stop<timeSupport::tscCpuidSerialized>(TS_LABEL("STOP"));
+    EXPECT_GE(rdtsct.getStopLapsedTSC(), 2'000'000);
+    EXPECT_LT(rdtsct.getStopLapsedTSC(), 1'000'000'000);
+    EXPECT_EQ(rdtsct.getStartCpu(), timeSupport::unknownCpu);
+    EXPECT_EQ(rdtsct.getStopCpu(), timeSupport::unknownCpu);
+    rdtsct();
+    EXPECT_NE(ss.str().find("> Clock: monotonic_raw"), std::string::npos);
+  }
+
+  // forced by the environment
+  setenv("TIME_SUPPORT_CLOCK", "tsc", 1);
+  EXPECT_EQ(timeSupport::selectClockBackend(), timeSupport::clockBackend::TSC);
+  setenv("TIME_SUPPORT_CLOCK", "monotonic_raw", 1);
+  EXPECT_EQ(timeSupport::selectClockBackend(), timeSupport::clockBackend::MONOTONIC_RAW);
+  unsetenv("TIME_SUPPORT_CLOCK");
+  EXPECT_EQ(timeSupport::selectClockBackend(), selected);
+}
+
+TEST(timeSupport, tscSkew)
+{
+  const std::vector<uint32_t>&& cpus = timeSupport::allowedCpus();
+
+  ASSERT_FALSE(cpus.empty());
+
+  // the same TSC: the offset is within half a round trip of 0
+  const timeSupport::tscSkewSample&& same = timeSupport::measureTscSkew(cpus[0], cpus[0], 200);
+
+  ASSERT_TRUE(same.valid);
+  EXPECT_GT(same.roundTrip, 0);
+  EXPECT_LE(static_cast<uint_fast64_t>(std::abs(same.offset)), same.roundTrip);
+
+  // a CPU that cannot be pinned
+  EXPECT_FALSE(timeSupport::measureTscSkew(CPU_SETSIZE, cpus[0], 10).valid);
+
+  const timeSupport::tscSkewMatrix&& measured = timeSupport::measureTscSkewMatrix(cpus, 100);
+  std::stringstream ss {};
+
+  ss << measured;
+  std::cout << ss.str();
+  EXPECT_NE(ss.str().find("TSC offset"), std::string::npos);
+  for (auto&& cpu : cpus)
+  {
+    EXPECT_TRUE(measured.has(cpu));
+    EXPECT_EQ(measured.offset(cpu, cpu), 0);
+  }
+
+  // the TSC of cpu 1 is 500 ticks ahead of the one of cpu 0
+  timeSupport::tscSkewMatrix skew {{0, 1}};
+
+  skew.set(0, 1, {500, 100, true});
+  EXPECT_EQ(skew.offset(0, 1), 500);
+  EXPECT_EQ(skew.offset(1, 0), -500);
+  EXPECT_EQ(skew.roundTrip(1, 0), 100);
+  EXPECT_EQ(skew.offset(0, 7), 0);
+  EXPECT_EQ(skew.correctedDelta(0, 1, 1'000, 2'500), 1'000);
+  EXPECT_EQ(skew.correctedDelta(1, 0, 1'000, 2'500), 2'000);
+
+  // a timer started and stopped on the same CPU is not corrected
+  timeSupport::rdtscTimer rdtsct {"T-SKEW", ss};
+
+  rdtsct.start(TS_LABEL("START"));
+  sumOfSquares(100);
+  rdtsct.stop(TS_LABEL("STOP"));
+  if ( !rdtsct.isCrossCore() )
+  {
+    EXPECT_EQ(rdtsct.getStopLapsedTSCSkewCorrected(measured), rdtsct.getStopLapsedTSC());
+  }
+
+  // nothing to measure when the timers fall back to CLOCK_MONOTONIC_RAW
+  const timeSupport::clockBackend selected {timeSupport::activeClockBackend()};
+
+  timeSupport::forceClockBackend(timeSupport::clockBackend::MONOTONIC_RAW);
+  EXPECT_FALSE(timeSupport::measureTscSkew(cpus[0], cpus[0], 10).valid);
+  EXPECT_TRUE(timeSupport::measureTscSkewMatrix(cpus, 10).getCpus().empty());
+  timeSupport::forceClockBackend(selected);
+}
+
+TEST(timeSupport, latencyBudget)
+{
+  std::stringstream ss {};
+
+  EXPECT_EQ(timeSupport::tsc_clock::toTicks(std::chrono::seconds(1)),
+            timeSupport::tsc_clock::calibration().tscHz);
+  EXPECT_EQ(timeSupport::tsc_clock::toTicks(std::chrono::nanoseconds(-1)), 0);
+
+  // a budget of 0 ticks: every region is over budget
+  timeSupport::exemplarLog slow {2};
+  {
+    timeSupport::rdtscTimer rdtsct {"T-BUDGET", ss};
+
+    rdtsct.setBudget(0, slow.recorder());
+    EXPECT_EQ(rdtsct.getBudget(), 0);
+    for (int&& i {0}; i < 3; ++i)
+    {
+      rdtsct.start(TS_LABEL("START"));
+      sumOfSquares(100);
+      rdtsct.stop(TS_LABEL("STOP"));
+    }
+    EXPECT_EQ(rdtsct.getOverBudgetCount(), 3);
+
+    // no budget, no exemplar
+    rdtsct.clearBudget();
+    rdtsct.start(TS_LABEL("START"));
+    rdtsct.stop(TS_LABEL("STOP"));
+    EXPECT_EQ(rdtsct.getOverBudgetCount(), 3);
+  }
+  EXPECT_EQ(slow.getRecordedCount(), 3);
+
+  const std::vector<timeSupport::budgetExemplar>&& exemplars = slow.snapshot();
+
+  ASSERT_EQ(exemplars.size(), 2);
+  for (auto&& e : exemplars)
+  {
+    EXPECT_EQ(e.timerId, timeSupport::internLabel("T-BUDGET"));
+    EXPECT_EQ(e.startLabel, timeSupport::internLabel("START"));
+    EXPECT_EQ(e.stopLabel, timeSupport::internLabel("STOP"));
+    EXPECT_EQ(e.budget, 0);
+    EXPECT_GT(e.ticks(), 0);
+    EXPECT_EQ(e.threadId, timeSupport::traceThreadId());
+  }
+  EXPECT_LT(exemplars[0].start, exemplars[1].start);
+  slow.report(ss);
+  EXPECT_NE(ss.str().find("T-BUDGET: START -> STOP: "), std::string::npos);
+
+  // the watchdog flags a running region past its deadline once, and only while it runs
+  std::mutex stallsMutex {};
+  std::vector<timeSupport::stalledRegion> stalls {};
+  {
+    timeSupport::deadlineWatchdog watchdog {[&stallsMutex, &stalls] (const timeSupport::stalledRegion& r)
+    {
+      std::lock_guard<std::mutex> lock {stallsMutex};
+
+      stalls.push_back(r);
+    }, std::chrono::hours(1)};
+    timeSupport::rdtscTimer rdtsct {"T-WATCHED", ss};
+
+    rdtsct.setBudget(timeSupport::tsc_clock::toTicks(std::chrono::milliseconds(1)))
+          .watchWith(&watchdog);
+    EXPECT_EQ(watchdog.getWatchedCount(), 1);
+    EXPECT_EQ(watchdog.scan(), 0);
+
+    rdtsct.start(TS_LABEL("START"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_EQ(watchdog.scan(), 1);
+    EXPECT_EQ(watchdog.scan(), 0);
+    rdtsct.stop(TS_LABEL("STOP"));
+    EXPECT_EQ(watchdog.scan(), 0);
+    EXPECT_EQ(rdtsct.getOverBudgetCount(), 1);
+
+    // a run within its deadline is not flagged
+    rdtsct.start(TS_LABEL("START"));
+    EXPECT_EQ(watchdog.scan(), 0);
+    rdtsct.stop(TS_LABEL("STOP"));
+
+    rdtsct.watchWith(nullptr);
+    EXPECT_EQ(watchdog.getWatchedCount(), 0);
+    EXPECT_EQ(watchdog.getStallsCount(), 1);
+  }
+  ASSERT_EQ(stalls.size(), 1);
+  EXPECT_EQ(stalls[0].timerId, timeSupport::internLabel("T-WATCHED"));
+  EXPECT_EQ(stalls[0].startLabel, timeSupport::internLabel("START"));
+  EXPECT_GT(stalls[0].now, stalls[0].deadline);
+  EXPECT_EQ(stalls[0].threadId, timeSupport::traceThreadId());
+
+  // the same from the background thread
+  std::atomic<uint_fast64_t> flagged {0};
+  {
+    timeSupport::deadlineWatchdog watchdog {[&flagged] (const timeSupport::stalledRegion&)
+    {
+      flagged.fetch_add(1, std::memory_order_relaxed);
+    }, std::chrono::milliseconds(1)};
+    timeSupport::rdtscTimer rdtsct {"T-WATCHED", ss};
+
+    rdtsct.setBudget(timeSupport::tsc_clock::toTicks(std::chrono::milliseconds(1)))
+          .watchWith(&watchdog);
+    rdtsct.start(TS_LABEL("START"));
+    for (int&& i {0}; (i < 1'000) && (0 == flagged.load(std::memory_order_relaxed)); ++i)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    rdtsct.stop(TS_LABEL("STOP"));
+  }
+  EXPECT_EQ(flagged.load(std::memory_order_relaxed), 1);
+}
+
+TEST(timeSupport, rateMeter)
+{
+  timeSupport::rateMeter meter {"requests"};
+  const uint_fast64_t t0 {meter.getStartTSC()};
+  const uint_fast64_t tick {meter.getTickTSC()};
+
+  EXPECT_EQ(meter.getName(), "requests");
+  EXPECT_EQ(meter.getCount(), 0);
+
+  // 50 events in the first tick: 500/s in every window
+  meter.mark(50);
+
+  const timeSupport::rateSnapshot&& first = meter.snapshotAt(t0 + tick + 1);
+
+  EXPECT_EQ(first.count, 50);
+  EXPECT_NEAR(first.meanRate, 500.0, 1.0);
+  EXPECT_NEAR(first.windowRate(timeSupport::rateWindow::ONE_SECOND), 500.0, 1e-9);
+  EXPECT_NEAR(first.windowRate(timeSupport::rateWindow::ONE_MINUTE), 500.0, 1e-9);
+  EXPECT_NEAR(first.ewmaRate(timeSupport::rateWindow::ONE_SECOND), 500.0, 1e-9);
+
+  // 10 idle ticks later: the 1s window is empty, the 10s one spans the 11
+  // ticks so far, the 1s average decayed by e
+  const timeSupport::rateSnapshot&& idle = meter.snapshotAt(t0 + (11 * tick));
+
+  EXPECT_NEAR(idle.windowRate(timeSupport::rateWindow::ONE_SECOND), 0.0, 1e-9);
+  EXPECT_NEAR(idle.windowRate(timeSupport::rateWindow::TEN_SECONDS), 50.0 / 1.1, 1e-9);
+  EXPECT_NEAR(idle.ewmaRate(timeSupport::rateWindow::ONE_SECOND), 500.0 * std::exp(-1.0), 1e-9);
+  EXPECT_NEAR(idle.ewmaRate(timeSupport::rateWindow::ONE_MINUTE), 500.0 * std::exp(-1.0 / 60.0), 1e-9);
+  EXPECT_GT(idle.ewmaRate(timeSupport::rateWindow::TEN_SECONDS), idle.ewmaRate(timeSupport::rateWindow::ONE_SECOND));
+
+  // an older TSC does not move the ticks back
+  const timeSupport::rateSnapshot&& older = meter.snapshotAt(t0);
+
+  EXPECT_NEAR(older.windowRate(timeSupport::rateWindow::TEN_SECONDS), 50.0 / 1.1, 1e-9);
+
+  // many threads mark without contending
+  std::vector<std::thread> threads {};
+
+  for (int&& i {0}; i < 4; ++i)
+  {
+    threads.emplace_back([&meter] ()
+    {
+      for (int&& j {0}; j < 10'000; ++j)
+      {
+        meter.mark();
+      }
+    });
+  }
+  for (auto&& t : threads)
+  {
+    t.join();
+  }
+  EXPECT_EQ(meter.getCount(), 40'050);
+  EXPECT_EQ(meter.snapshot().count, 40'050);
+  EXPECT_GT(meter.getMeanRate(), 0.0);
+
+  std::stringstream ss {};
+
+  meter.report(ss);
+  EXPECT_EQ(ss.str().find("requests: count 40050, mean "), 0);
+  EXPECT_NE(ss.str().find(", EWMA 1s "), std::string::npos);
+}
+
+TEST(timeSupport, rateMeterConcurrentReads)
+{
+  timeSupport::rateMeter meter {"concurrent"};
+  std::atomic<bool> done {false};
+  std::atomic<bool> sane {true};
+  std::vector<std::thread> threads {};
+  constexpr uint_fast64_t marks {1'000'000};
+
+  // two threads mark while two others read, over a few ticks
+  for (int&& i {0}; i < 2; ++i)
+  {
+    threads.emplace_back([&meter] ()
+    {
+      for (uint_fast64_t&& j {0}; j < marks; ++j)
+      {
+        meter.mark();
+        if ( 0 == (j & 1023) )
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int&& i {0}; i < 2; ++i)
+  {
+    threads.emplace_back([&meter, &done, &sane] ()
+    {
+      while ( !done.load(std::memory_order_acquire) )
+      {
+        const timeSupport::rateSnapshot&& s = meter.snapshot();
+
+        // all the marks in a single tick is the highest rate possible
+        for (std::size_t&& w {0}; w < timeSupport::rateWindowsCount; ++w)
+        {
+          if ( (s.windowRates[w] > (20.0 * marks)) || (s.ewmaRates[w] > (20.0 * marks)) )
+          {
+            sane.store(false, std::memory_order_relaxed);
+          }
+        }
+        std::this_thread::yield();
+      }
+    });
+  }
+  threads[0].join();
+  threads[1].join();
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  done.store(true, std::memory_order_release);
+  threads[2].join();
+  threads[3].join();
+  EXPECT_TRUE(sane.load());
+  EXPECT_EQ(meter.snapshot().count, 2 * marks);
+}
+
+TEST(timeSupport, rateMeterSteadyLoad)
+{
+  timeSupport::rateMeter meter {"scraped"};
+  const uint_fast64_t t0 {meter.getStartTSC()};
+  const uint_fast64_t tick {meter.getTickTSC()};
+
+  // 1000/s for 10 s, read once at the end as a scrape would
+  meter.mark(10'000);
+
+  const timeSupport::rateSnapshot&& first = meter.snapshotAt(t0 + (100 * tick) + 1);
+
+  EXPECT_NEAR(first.windowRate(timeSupport::rateWindow::ONE_SECOND), 1'000.0, 1e-9);
+  EXPECT_NEAR(first.windowRate(timeSupport::rateWindow::TEN_SECONDS), 1'000.0, 1e-9);
+  EXPECT_NEAR(first.ewmaRate(timeSupport::rateWindow::ONE_SECOND), 1'000.0, 1e-9);
+
+  // then 2000/s for 10 s: the 1s window and average follow, the 1m average
+  // lags by its time constant
+  meter.mark(20'000);
+
+  const timeSupport::rateSnapshot&& second = meter.snapshotAt(t0 + (200 * tick) + 1);
+
+  EXPECT_NEAR(second.windowRate(timeSupport::rateWindow::ONE_SECOND), 2'000.0, 1e-9);
+  EXPECT_NEAR(second.windowRate(timeSupport::rateWindow::ONE_MINUTE), 1'500.0, 1e-9);
+  EXPECT_NEAR(second.ewmaRate(timeSupport::rateWindow::ONE_SECOND), 2'000.0 - (1'000.0 * std::exp(-10.0)), 1e-6);
+  EXPECT_NEAR(second.ewmaRate(timeSupport::rateWindow::ONE_MINUTE), 2'000.0 - (1'000.0 * std::exp(-10.0 / 60.0)), 1e-6);
+
+  // an uneven split loses no event
+  meter.mark(7);
+
+  const timeSupport::rateSnapshot&& third = meter.snapshotAt(t0 + (210 * tick) + 1);
+
+  EXPECT_NEAR(third.windowRate(timeSupport::rateWindow::ONE_SECOND), 7.0, 1e-9);
+}
+
+TEST(timeSupport, compactTimer)
+{
+  using status = timeSupport::compactTimer::rdtscTimerStatus;
+
+  static_assert(std::is_trivially_copyable_v<timeSupport::compactTimer>);
+  static_assert(sizeof(timeSupport::compactTimer) <= 64);
+  EXPECT_LT(sizeof(timeSupport::compactTimer), sizeof(timeSupport::rdtscTimer));
+
+  std::stringstream ss {};
+  timeSupport::compactTimer t {TS_LABEL("T-COMPACT")};
+
+  EXPECT_EQ(t.getTimerStatus(), status::INACTIVE);
+  t.stop(TS_LABEL("STOP-NOT-STARTED"));
+  EXPECT_EQ(t.getTimerStatus(), status::INACTIVE);
+  t.start(TS_LABEL("START"));
+  sumOfSquares(100);
+  t.stop(TS_LABEL("STOP"));
+  EXPECT_EQ(t.getTimerStatus(), status::STOPPED);
+  EXPECT_GT(t.getStopLapsedTSC(), 0);
+  EXPECT_EQ(t.getStopLapsedTSC(), t.getStopTSC() - t.getStartTSC());
+
+  // a copy is a snapshot
+  const timeSupport::compactTimer copy {t};
+
+  t.report(ss);
+  EXPECT_EQ(t.getTimerStatus(), status::REPORTED);
+  EXPECT_EQ(copy.getTimerStatus(), status::STOPPED);
+  EXPECT_EQ(ss.str().find("T-COMPACT: START -> STOP: Timer started at "), 0);
+
+  // a structure of arrays of per-entity timers
+  timeSupport::compactTimerArray connections {1'000, TS_LABEL("connection")};
+
+  EXPECT_EQ(connections.size(), 1'000);
+  EXPECT_EQ(connections.count(status::INACTIVE), 1'000);
+  for (std::size_t&& i {0}; i < connections.size(); i += 2)
+  {
+    connections.start(i, TS_LABEL("OPEN"));
+  }
+  for (std::size_t&& i {0}; i < connections.size(); i += 4)
+  {
+    connections.stop(i, TS_LABEL("CLOSE"));
+  }
+  EXPECT_EQ(connections.count(status::STARTED), 250);
+  EXPECT_EQ(connections.count(status::STOPPED), 250);
+  EXPECT_EQ(connections.getStopLapsedTSC(1), 0);
+  EXPECT_GT(connections.getStopLapsedTSC(4), 0);
+
+  const timeSupport::tickHistogram&& h = connections.histogram();
+
+  EXPECT_EQ(h.getCount(), 250);
+  EXPECT_GT(h.getMin(), 0);
+
+  const timeSupport::compactTimer&& c4 = connections.get(4);
+
+  EXPECT_EQ(c4.getNameId(), timeSupport::internLabel("connection"));
+  EXPECT_EQ(c4.getStopLapsedTSC(), connections.getStopLapsedTSC(4));
+  connections.set(1, c4);
+  EXPECT_EQ(connections.getStopLapsedTSC(1), c4.getStopLapsedTSC());
+
+  ss.str("");
+  EXPECT_EQ(connections.report(ss), 251);
+  EXPECT_EQ(connections.count(status::REPORTED), 251);
+  EXPECT_NE(ss.str().find("connection[4]: OPEN -> CLOSE: "), std::string::npos);
+  EXPECT_EQ(connections.report(ss), 0);
+  EXPECT_EQ(connections.histogram().getCount(), 251);
+
+  connections.reset();
+  EXPECT_EQ(connections.count(status::INACTIVE), 1'000);
+  connections.resize(10);
+  EXPECT_EQ(connections.size(), 10);
+}
+
+TEST(timeSupport, sampling)
+{
+  // fixed: every 4th execution
+  timeSupport::sampleCountdown fixed {4};
+  uint_fast64_t taken {0};
+
+  for (int&& i {1}; i <= 1'000; ++i)
+  {
+    if ( fixed.take() )
+    {
+      EXPECT_EQ(i % 4, 0);
+      ++taken;
+    }
+  }
+  EXPECT_EQ(taken, 250);
+  EXPECT_EQ(fixed.getWeight(), 4);
+
+  // geometric: gaps of mean 10
+  timeSupport::sampleCountdown geometric {10, timeSupport::samplingMode::GEOMETRIC, 42};
+
+  taken = 0;
+  for (int&& i {0}; i < 100'000; ++i)
+  {
+    taken += geometric.take() ? 1 : 0;
+  }
+  EXPECT_NEAR(static_cast<double>(taken), 10'000.0, 500.0);
+
+  // no sampling: every execution
+  timeSupport::sampleCountdown every {};
+
+  EXPECT_TRUE(every.take() && every.take());
+
+  // the histogram counts all the runs, from one timed run in 4
+  std::stringstream ss {};
+  timeSupport::latencyHistogram histogram {"sampled"};
+  {
+    timeSupport::rdtscTimer rdtsct {"T-SAMPLED", ss};
+
+    rdtsct.recordInto(&histogram).sampleEvery(4);
+    EXPECT_EQ(rdtsct.getSampleWeight(), 4);
+    for (int&& i {0}; i < 1'000; ++i)
+    {
+      rdtsct.start(TS_LABEL("START")).lap(TS_LABEL("LAP"));
+      rdtsct.stop(TS_LABEL("STOP")).report();
+    }
+  }
+  EXPECT_EQ(histogram.snapshot().getCount(), 1'000);
+  EXPECT_TRUE(ss.str().empty());
+
+  // the runs left out report nothing, and no error
+  {
+    timeSupport::rdtscTimer rdtsct {"T-SAMPLED-LINES", ss};
+    int calls {0};
+
+    rdtsct.sampleEvery(4);
+    for (int&& i {0}; i < 8; ++i)
+    {
+      timeSupport::profileFunction(rdtsct, TS_LABEL("START"), TS_LABEL("STOP"), [&calls] () { ++calls; });
+    }
+    EXPECT_EQ(calls, 8);
+  }
+  const std::string&& lines = ss.str();
+
+  EXPECT_EQ(std::count(lines.begin(), lines.end(), '\n'), 2);
+  EXPECT_EQ(lines.find("ERROR"), std::string::npos);
+
+  // a timed run not yet reported when the next start() is left out is still
+  // reported, by report() or by the dtor
+  std::stringstream pending {};
+  {
+    timeSupport::rdtscTimer rdtsct {"T-SAMPLED-PENDING", pending};
+
+    rdtsct.sampleEvery(2);
+    rdtsct.start(TS_LABEL("OUT")).stop(TS_LABEL("OUT"));
+    rdtsct.start(TS_LABEL("TIMED")).stop(TS_LABEL("STOP"));
+    rdtsct.start(TS_LABEL("OUT"));
+    EXPECT_TRUE(rdtsct.isSampledOut());
+    rdtsct.report();
+    EXPECT_EQ(rdtsct.getTimerStatus(), timeSupport::rdtscTimer::rdtscTimerStatus::REPORTED);
+    rdtsct.report();
+  }
+  {
+    timeSupport::rdtscTimer rdtsct {"T-SAMPLED-DTOR", pending};
+
+    rdtsct.sampleEvery(2);
+    rdtsct.start(TS_LABEL("OUT")).stop(TS_LABEL("OUT"));
+    rdtsct.start(TS_LABEL("TIMED")).stop(TS_LABEL("STOP"));
+    rdtsct.start(TS_LABEL("OUT"));
+  }
+
+  const std::string&& pendingLines = pending.str();
+
+  EXPECT_EQ(std::count(pendingLines.begin(), pendingLines.end(), '\n'), 2);
+  EXPECT_NE(pendingLines.find("T-SAMPLED-PENDING: TIMED -> STOP"), std::string::npos);
+  EXPECT_NE(pendingLines.find("T-SAMPLED-DTOR: TIMED -> STOP"), std::string::npos);
+  EXPECT_EQ(pendingLines.find("ERROR"), std::string::npos);
+
+  // the stage statistics are weighted too
+  timeSupport::stageStatistics stages {"sampled", 2};
+  {
+    timeSupport::rdtscTimer rdtsct {"T-SAMPLED-STAGES", ss};
+
+    rdtsct.recordStagesInto(&stages).sampleEvery(10);
+    for (int&& i {0}; i < 100; ++i)
+    {
+      rdtsct.start(TS_LABEL("START")).lap(TS_LABEL("LAP"));
+      rdtsct.stop(TS_LABEL("STOP"));
+    }
+  }
+  EXPECT_EQ(stages.getRuns(), 100);
+  EXPECT_EQ(stages.snapshot(0).getCount(), 100);
+
+  // a sampled zone estimates the calls of all the executions
+  auto&& sampledWork = [] ()
+  {
+    TIME_ZONE_SAMPLED("sampledWork", 16);
+  };
+
+  for (int&& i {0}; i < 100'000; ++i)
+  {
+    sampledWork();
+  }
+
+  const timeSupport::zoneDescriptor* zone {nullptr};
+
+  for (auto&& z = timeSupport::firstZone(); nullptr != z; z = z->getNext())
+  {
+    if ( std::string("sampledWork") == z->getName() )
+    {
+      zone = z;
+    }
+  }
+  ASSERT_NE(zone, nullptr);
+
+  const timeSupport::zoneStatistics&& zs = zone->snapshot();
+
+  EXPECT_EQ(zs.count % 16, 0);
+  EXPECT_NEAR(static_cast<double>(zs.count), 100'000.0, 10'000.0);
+}
+
+#ifdef TIME_SUPPORT_HAS_COROUTINES
+// built with -std=c++20 only
+namespace
+{
+// a local executor: schedule() queues the coroutine, run() resumes the
+// coroutines queued so far on the calling thread
+struct localExecutor
+{
+  std::deque<std::coroutine_handle<>> queue {};
+
+  auto
+  schedule() noexcept
+  {
+    struct awaiter
+    {
+      localExecutor& executor;
+
+      bool await_ready() const noexcept { return false; }
+      void await_suspend(std::coroutine_handle<> h) { executor.queue.push_back(h); }
+      void await_resume() const noexcept {}
+    };
+
+    return awaiter{*this};
+  }
+
+  std::size_t
+  run()
+  {
+    std::size_t resumed {0};
+
+    for (std::size_t&& n {queue.size()}; n > 0; --n)
+    {
+      std::coroutine_handle<> h {queue.front()};
+
+      queue.pop_front();
+      h.resume();
+      ++resumed;
+    }
+    return resumed;
+  }
+};
+
+// a coroutine run eagerly and destroyed at its end
+struct detachedTask
+{
+  struct promise_type
+  {
+    detachedTask get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+// an awaitable through operator co_await whose awaiter does not suspend
+struct answerAwaitable
+{
+  struct awaiter
+  {
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<>) const noexcept { return false; }
+    int await_resume() const noexcept { return 42; }
+  };
+
+  awaiter operator co_await() const noexcept { return {}; }
+};
+
+detachedTask
+spannedWork(localExecutor& executor, timeSupport::coroutineSpan& span, int& answer)
+{
+  span.start(TS_LABEL("START"));
+  sumOfSquares(1'000);
+  co_await timeSupport::timed(span, executor.schedule());
+  sumOfSquares(1'000);
+  answer = co_await timeSupport::timed(span, answerAwaitable{});
+  co_await timeSupport::timed(span, executor.schedule());
+  span.stop(TS_LABEL("STOP"));
+}
+}  // namespace
+
+TEST(timeSupport, coroutineSpan)
+{
+  localExecutor executor {};
+  timeSupport::coroutineSpan span {TS_LABEL("T-CORO")};
+  int answer {0};
+
+  spannedWork(executor, span, answer);
+  EXPECT_EQ(span.getSuspensionsCount(), 1);
+  EXPECT_FALSE(span.isActive());
+
+  // suspended for 20 msec: wall time, not active time
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(executor.run(), 1);
+  EXPECT_EQ(answer, 42);
+  EXPECT_EQ(span.getSuspensionsCount(), 2);
+  EXPECT_FALSE(span.isStopped());
+
+  // resumed on another thread
+  std::thread resumer {[&executor] () { executor.run(); }};
+
+  resumer.join();
+  ASSERT_TRUE(span.isStopped());
+  EXPECT_GE(span.getWall_nsec(), 20'000'000);
+  EXPECT_GT(span.getActiveTSC(), 0);
+  EXPECT_LT(span.getActiveTSC(), span.getWallTSC() / 2);
+  EXPECT_EQ(span.getSuspendedTSC(), span.getWallTSC() - span.getActiveTSC());
+
+  std::stringstream ss {};
+
+  span.report(ss);
+  EXPECT_EQ(ss.str().find("T-CORO: START -> STOP: active "), 0);
+  EXPECT_NE(ss.str().find(", 2 suspensions, "), std::string::npos);
+}
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 // the following tests need super user rights
 // they fail when run as a user with standard privileges